@@ -32,10 +32,10 @@ call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build
 
 :: User Variables ::
 set EXE_NAME=todo_finder.exe
-set RUN_ARGS=. clang release
+set RUN_ARGS=.
 set SOURCE_DIR=src
 set CPP_STANDARD=c++17
-set DEBUG_FLAGS=-g -O0 -DDEBUG -D_DEBUG -Xclang --dependent-lib=libcmtd
+set DEBUG_FLAGS=-g -O0 -DDEBUG -D_DEBUG -DTRACK_ALLOCATIONS -Xclang --dependent-lib=libcmtd
 set RELEASE_W_DEBUG_FLAGS=-g -O2 -DNDEBUG 
 set RELEASE_FLAGS=-O2 -DNDEBUG 
 set SHIPPING_FLAGS=-O2 -w -DNDEBUG 
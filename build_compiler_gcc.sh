@@ -7,23 +7,42 @@
 
 # User Variables
 EXE_NAME="todo_finder"
+LIBRARY_NAME="libtodo_finder"
+LIBRARY_FLAGS="-fPIC -DTODO_FINDER_LIBRARY"
+BAKED_CONFIG="coco.todo_config"
+GENERATOR_SOURCE="tools/generate_matcher.c"
 SOURCE_DIR="src"
 CPP_STANDARD="c++17"
-DEBUG_FLAGS="-g -O0 -DDEBUG -D_DEBUG"
+DEBUG_FLAGS="-g -O0 -DDEBUG -D_DEBUG -DTRACK_ALLOCATIONS"
 RELEASE_W_DEBUG_FLAGS="-g -O2 -DNDEBUG"
 RELEASE_FLAGS="-O2 -DNDEBUG"
 SHIPPING_FLAGS="-O2 -w -DNDEBUG"
+THREAD_FLAGS="-pthread"
 
 # check args
 if [ -z "$1" ]; then
     echo "Error: No configuration specified"
-    echo "Usage: $0 [debug|release_with_debug|release|shipping]"
+    echo "Usage: $0 [debug|release_with_debug|release|shipping] [library|baked]"
     exit 1
 fi
 
 # Configuration
+# a second argument of library builds libtodo_finder.a and .so from everything but main.c, see src/todo_finder.h
+# a second argument of baked compiles the [symbols] and [keywords] of coco.todo_config into the matcher
 CONFIG=$1
+BUILD_LIBRARY=0
+BUILD_BAKED=0
+if [ "$2" == "library" ]; then
+    BUILD_LIBRARY=1
+elif [ "$2" == "baked" ]; then
+    BUILD_BAKED=1
+fi
 OUTPUT_ROOT="gcc"
+if [ $BUILD_LIBRARY -eq 1 ]; then
+    OUTPUT_ROOT="gcc_library"
+elif [ $BUILD_BAKED -eq 1 ]; then
+    OUTPUT_ROOT="gcc_baked"
+fi
 COMPILER="gcc"
 CPP_COMPILER="g++"
 LINKER="g++"
@@ -55,6 +74,29 @@ find_source_files() {
     return 0
 }
 
+# builds the generator from the same sources as the program so it reads the config exactly the same way
+# then writes baked_matcher.h into the build directory, a config it can't bake just means a normal build
+generate_stage() {
+    local generated_dir="$OUTPUT_ROOT/$CONFIG/generated"
+    local generator="$OUTPUT_ROOT/$CONFIG/generate_matcher"
+    local generator_sources=()
+    for file in $file_list; do
+        if [ "$(basename "$file")" != "main.c" ]; then
+            generator_sources+=("$file")
+        fi
+    done
+    
+    echo "Generating baked matcher from $BAKED_CONFIG..."
+    mkdir -p "$generated_dir"
+    if $COMPILER -O2 -DNDEBUG -DTODO_FINDER_LIBRARY $THREAD_FLAGS "$GENERATOR_SOURCE" "${generator_sources[@]}" -o "$generator" && \
+       "./$generator" "$BAKED_CONFIG" "$generated_dir/baked_matcher.h"; then
+        BASE_FLAGS="$BASE_FLAGS -DTODO_BAKED_MATCHER -I$generated_dir"
+    else
+        echo "Could not bake $BAKED_CONFIG, building the dynamic matcher only"
+    fi
+    echo .
+}
+
 compile_stage() {
     echo "Compiling source files..."
     echo .
@@ -93,10 +135,22 @@ compile_stage() {
         ;;
     esac
     
+    BASE_FLAGS="$BASE_FLAGS $THREAD_FLAGS"
+    if [ $BUILD_LIBRARY -eq 1 ]; then
+        BASE_FLAGS="$BASE_FLAGS $LIBRARY_FLAGS"
+    fi
+    
+    if [ $BUILD_BAKED -eq 1 ]; then
+        generate_stage
+    fi
+    
     # Compile each file 
     OBJECT_FILES=()
     for file in $file_list; do
         src_file=$(basename "$file")
+        if [ $BUILD_LIBRARY -eq 1 ] && [ "$src_file" == "main.c" ]; then
+            continue
+        fi
         echo "Compiling: $file"
         
         case "$src_file" in
@@ -132,8 +186,22 @@ compile_stage() {
 }
 
 link_stage() {
+    if [ $BUILD_LIBRARY -eq 1 ]; then
+        echo "Archiving library..."
+        if ! ar rcs "$OUTPUT_ROOT/$CONFIG/$LIBRARY_NAME.a" "${OBJECT_FILES[@]}"; then
+            echo "Archiving failed!"
+            return 1
+        fi
+        if ! $COMPILER -shared $THREAD_FLAGS "${OBJECT_FILES[@]}" -o "$OUTPUT_ROOT/$CONFIG/$LIBRARY_NAME.so"; then
+            echo "Linking shared library failed!"
+            return 1
+        fi
+        echo "Build succeeded: $OUTPUT_ROOT/$CONFIG/$LIBRARY_NAME.a $OUTPUT_ROOT/$CONFIG/$LIBRARY_NAME.so"
+        return 0
+    fi
+    
     echo "Linking executable..."
-    if ! $LINKER "${OBJECT_FILES[@]}" $LINK_FLAGS; then
+    if ! $LINKER $THREAD_FLAGS "${OBJECT_FILES[@]}" $LINK_FLAGS; then
         echo "Linking failed!"
         return 1
     fi
@@ -276,6 +344,10 @@ clean_menu() {
 }
 
 if compile_stage && link_stage; then
+    # there is nothing to run for a library build
+    if [ $BUILD_LIBRARY -eq 1 ]; then
+        exit 0
+    fi
     menu_prompt
 else
     echo "Build failed!"
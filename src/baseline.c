@@ -0,0 +1,382 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// a baseline file is the sorted entries followed by their pool, numbers are little endian
+//
+//     "TDFB" u32 version u32 entry_count u32 pool_size
+//     per entry: u64 fingerprint, u32 name_offset, u32 path_offset, u32 text_offset
+//     pool_size bytes of nul terminated strings
+
+#define BaselineMagic "TDFB"
+#define BaselineVersion 1
+#define BaselineEntrySize 20
+
+// only kept for reporting a removed match, the hash covers the whole text
+#define MaxBaselineText 256
+
+static u64 HashText(u64 hash, const char* text, usize length)
+{
+    for (usize i = 0; i < length; i++)
+    {
+        hash ^= (u8)(text[i]);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static bool Baseline_AddEntry(Baseline* baseline)
+{
+    if (baseline->count < baseline->capacity) { return true; }
+    usize new_capacity = baseline->capacity ? baseline->capacity * 2 : 1024;
+    BaselineEntry* new_entries = (BaselineEntry*)(realloc(baseline->entries, new_capacity * sizeof(BaselineEntry)));
+    if (!new_entries) { return false; }
+    baseline->entries = new_entries;
+    baseline->capacity = new_capacity;
+    return true;
+}
+
+static bool Baseline_ReservePool(Baseline* baseline, usize size)
+{
+    if (baseline->pool_size + size <= baseline->pool_capacity) { return true; }
+    usize new_capacity = baseline->pool_capacity ? baseline->pool_capacity * 2 : 64 * 1024;
+    while (new_capacity < baseline->pool_size + size) { new_capacity *= 2; }
+    char* new_pool = (char*)(realloc(baseline->pool, new_capacity));
+    if (!new_pool) { return false; }
+    baseline->pool = new_pool;
+    baseline->pool_capacity = new_capacity;
+    return true;
+}
+
+static u32 Baseline_PushString(Baseline* baseline, const char* text, usize length)
+{
+    u32 offset = (u32)(baseline->pool_size);
+    memcpy(baseline->pool + baseline->pool_size, text, length);
+    baseline->pool[baseline->pool_size + length] = '\0';
+    baseline->pool_size += length + 1;
+    return offset;
+}
+
+void AddBaselineEntry(MessageTable* message_table, usize bucket_index, const char* path, s32 line_number, const char* text, usize text_length)
+{
+    Baseline* baseline = &message_table->baseline;
+    usize path_length = StringLength(path);
+    if (!Baseline_AddEntry(baseline) || !Baseline_ReservePool(baseline, 128 + path_length + MaxBaselineText + 3))
+    {
+        LogDebug("AddBaselineEntry, out of memory, %s:%d is left out of the baseline\n", path, line_number);
+        return;
+    }
+    
+    // matches come a file at a time, so the path and name are usually the ones the last entry already pooled
+    BaselineEntry* last = baseline->count ? &baseline->entries[baseline->count - 1] : 0;
+    BaselineEntry* entry = &baseline->entries[baseline->count++];
+    entry->line_number = line_number;
+    
+    if (last && StringCompare(baseline->pool + last->path_offset, path) == 0) 
+    { 
+        entry->path_offset = last->path_offset; 
+    }
+    else
+    {
+        entry->path_offset = Baseline_PushString(baseline, path, path_length);
+        baseline->last_path_hash = HashText(0xCBF29CE484222325ull, path, path_length);
+    }
+    
+    if (last && baseline->last_bucket == bucket_index + 1) 
+    { 
+        entry->name_offset = last->name_offset; 
+    }
+    else
+    {
+        char name[128];
+        GetBucketName(message_table, bucket_index, name, sizeof(name));
+        usize name_length = StringLength(name);
+        entry->name_offset = Baseline_PushString(baseline, name, name_length);
+        baseline->last_name_hash = HashText(0xCBF29CE484222325ull, name, name_length);
+        baseline->last_bucket = bucket_index + 1;
+    }
+    
+    // whitespace runs become one space and the ends are trimmed, so reindenting or retabbing isn't a new match
+    char* kept_text = baseline->pool + baseline->pool_size;
+    u64 text_hash = 0xCBF29CE484222325ull;
+    usize kept = 0;
+    bool pending_space = false;
+    for (usize i = 0; i < text_length; i++)
+    {
+        char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f')
+        {
+            pending_space = true;
+            continue;
+        }
+        if (pending_space && kept > 0)
+        {
+            text_hash = HashText(text_hash, " ", 1);
+            if (kept < MaxBaselineText) { kept_text[kept++] = ' '; }
+        }
+        pending_space = false;
+        text_hash = HashText(text_hash, &c, 1);
+        if (kept < MaxBaselineText) { kept_text[kept++] = c; }
+    }
+    kept_text[kept] = '\0';
+    entry->text_offset = (u32)(baseline->pool_size);
+    baseline->pool_size += kept + 1;
+    
+    u64 fingerprint = (baseline->last_path_hash ^ baseline->last_name_hash) * 0x9E3779B97F4A7C15ull;
+    fingerprint = (fingerprint ^ text_hash) * 0xFF51AFD7ED558CCDull;
+    entry->fingerprint = fingerprint ^ (fingerprint >> 33);
+}
+
+void FreeBaseline(Baseline* baseline)
+{
+    free(baseline->entries);
+    free(baseline->pool);
+    memset(baseline, 0, sizeof(Baseline));
+}
+
+static int CompareFingerprints(const void* left, const void* right)
+{
+    u64 left_fingerprint = ((const BaselineEntry*)(left))->fingerprint;
+    u64 right_fingerprint = ((const BaselineEntry*)(right))->fingerprint;
+    return (left_fingerprint > right_fingerprint) - (left_fingerprint < right_fingerprint);
+}
+
+// lsd radix sort on the fingerprint a byte at a time, bytes that are the same everywhere are skipped
+// falls back to qsort when there is no memory for the second buffer
+static void SortByFingerprint(BaselineEntry* entries, usize count)
+{
+    BaselineEntry* scratch = (count > 1) ? (BaselineEntry*)(malloc(count * sizeof(BaselineEntry))) : 0;
+    if (!scratch)
+    {
+        if (count > 1) { qsort(entries, count, sizeof(BaselineEntry), CompareFingerprints); }
+        return;
+    }
+    
+    BaselineEntry* from = entries;
+    BaselineEntry* to = scratch;
+    for (u32 shift = 0; shift < 64; shift += 8)
+    {
+        usize offsets[256] = {0};
+        for (usize i = 0; i < count; i++) { offsets[(from[i].fingerprint >> shift) & 0xFF]++; }
+        if (offsets[(from[0].fingerprint >> shift) & 0xFF] == count) { continue; }
+        
+        usize total = 0;
+        for (usize b = 0; b < 256; b++)
+        {
+            usize bucket_count = offsets[b];
+            offsets[b] = total;
+            total += bucket_count;
+        }
+        for (usize i = 0; i < count; i++) { to[offsets[(from[i].fingerprint >> shift) & 0xFF]++] = from[i]; }
+        
+        BaselineEntry* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != entries) { memcpy(entries, from, count * sizeof(BaselineEntry)); }
+    free(scratch);
+}
+
+static void PutNumber(u8* at, u64 value, usize byte_count)
+{
+    for (usize i = 0; i < byte_count; i++) { at[i] = (u8)(value >> (i * 8)); }
+}
+
+static u64 GetNumber(const u8* at, usize byte_count)
+{
+    u64 value = 0;
+    for (usize i = 0; i < byte_count; i++) { value |= (u64)(at[i]) << (i * 8); }
+    return value;
+}
+
+bool SaveBaseline(MessageTable* message_table, const char* path)
+{
+    Baseline* baseline = &message_table->baseline;
+    SortByFingerprint(baseline->entries, baseline->count);
+    
+    usize size = 16 + baseline->count * BaselineEntrySize + baseline->pool_size;
+    u8* data = (u8*)(malloc(size));
+    if (!data)
+    {
+        Log("Failed to write the baseline to %s, out of memory\n", path);
+        return false;
+    }
+    
+    memcpy(data, BaselineMagic, 4);
+    PutNumber(data + 4, BaselineVersion, 4);
+    PutNumber(data + 8, baseline->count, 4);
+    PutNumber(data + 12, baseline->pool_size, 4);
+    u8* at = data + 16;
+    for (usize i = 0; i < baseline->count; i++, at += BaselineEntrySize)
+    {
+        PutNumber(at, baseline->entries[i].fingerprint, 8);
+        PutNumber(at + 8, baseline->entries[i].name_offset, 4);
+        PutNumber(at + 12, baseline->entries[i].path_offset, 4);
+        PutNumber(at + 16, baseline->entries[i].text_offset, 4);
+    }
+    if (baseline->pool_size) { memcpy(at, baseline->pool, baseline->pool_size); }
+    
+    bool written = false;
+    File file = {0};
+    if (FileOpen(&file, path, "wb"))
+    {
+        MemoryBuffer buffer = { (char*)(data), size };
+        written = FileWrite(&buffer, size, &file) == size;
+        FileClose(&file);
+    }
+    if (!written) { Log("Failed to write the baseline to %s\n", path); }
+    
+    free(data);
+    return written;
+}
+
+// the entries come out of the file already sorted, the pool is copied so the file can go
+static bool LoadBaseline(Baseline* baseline, const char* path)
+{
+    FileContents contents = {0};
+    usize size = GetFileContents(&contents, path);
+    const u8* data = (const u8*)(contents.memory.buffer);
+    
+    bool loaded = false;
+    if (size < 16 || memcmp(data, BaselineMagic, 4) != 0 || GetNumber(data + 4, 4) != BaselineVersion)
+    {
+        Log("--diff-baseline, %s is not a baseline file\n", path);
+    }
+    else
+    {
+        usize count = (usize)(GetNumber(data + 8, 4));
+        usize pool_size = (usize)(GetNumber(data + 12, 4));
+        if (size != 16 + count * BaselineEntrySize + pool_size || (pool_size && data[size - 1] != '\0'))
+        {
+            Log("--diff-baseline, %s is truncated\n", path);
+        }
+        else if (!Baseline_ReservePool(baseline, pool_size + 1) || (count && !(baseline->entries = (BaselineEntry*)(malloc(count * sizeof(BaselineEntry))))))
+        {
+            Log("--diff-baseline, out of memory reading %s\n", path);
+        }
+        else
+        {
+            const u8* at = data + 16;
+            for (usize i = 0; i < count; i++, at += BaselineEntrySize)
+            {
+                BaselineEntry* entry = &baseline->entries[i];
+                entry->fingerprint = GetNumber(at, 8);
+                entry->name_offset = (u32)(GetNumber(at + 8, 4));
+                entry->path_offset = (u32)(GetNumber(at + 12, 4));
+                entry->text_offset = (u32)(GetNumber(at + 16, 4));
+                entry->line_number = 0;
+                
+                // the pool ends with a nul, so an offset inside it always reads a string
+                if (entry->name_offset >= pool_size) { entry->name_offset = 0; }
+                if (entry->path_offset >= pool_size) { entry->path_offset = 0; }
+                if (entry->text_offset >= pool_size) { entry->text_offset = 0; }
+            }
+            memcpy(baseline->pool, at, pool_size);
+            baseline->pool[pool_size] = '\0';
+            baseline->count = count;
+            baseline->capacity = count;
+            baseline->pool_size = pool_size;
+            loaded = true;
+        }
+    }
+    
+    FreeFileContents(&contents);
+    return loaded;
+}
+
+// text offsets follow the order the matches were found in, so sorting by them lists files and lines in scan order
+static int CompareTextOffsets(const void* left, const void* right)
+{
+    u32 left_offset = ((const BaselineEntry*)(left))->text_offset;
+    u32 right_offset = ((const BaselineEntry*)(right))->text_offset;
+    return (left_offset > right_offset) - (left_offset < right_offset);
+}
+
+static void PrintBaselineChanges(Baseline* baseline, BaselineEntry* entries, usize count, const char* what, const char* path)
+{
+    if (count == 0)
+    {
+        Log("No matches %s since %s\n\n", what, path);
+        return;
+    }
+    
+    qsort(entries, count, sizeof(BaselineEntry), CompareTextOffsets);
+    Log("%zu %s %s since %s:\n\n", count, (count > 1) ? "matches" : "match", what, path);
+    for (usize i = 0; i < count; i++)
+    {
+        const char* file = baseline->pool + entries[i].path_offset;
+        const char* text = baseline->pool + entries[i].text_offset;
+        if (entries[i].line_number > 0) { Log("    %-48s %4d: %s\n", file, entries[i].line_number, text); }
+        else                            { Log("    %-48s       %s\n", file, text); }
+    }
+    Log("\n");
+}
+
+bool PrintBaselineDiff(MessageTable* message_table, const char* path)
+{
+    Baseline saved = {0};
+    Baseline* current = &message_table->baseline;
+    BaselineEntry* added = (BaselineEntry*)(malloc((current->count + 1) * sizeof(BaselineEntry)));
+    BaselineEntry* removed = 0;
+    bool loaded = added && LoadBaseline(&saved, path);
+    if (loaded) { removed = (BaselineEntry*)(malloc((saved.count + 1) * sizeof(BaselineEntry))); }
+    if (!loaded || !removed)
+    {
+        if (loaded) { Log("--diff-baseline, out of memory\n"); }
+        free(added);
+        FreeBaseline(&saved);
+        return false;
+    }
+    
+    // both sides sorted by fingerprint, equal fingerprints pair off and whatever is left over changed
+    SortByFingerprint(current->entries, current->count);
+    usize added_count = 0;
+    usize removed_count = 0;
+    usize c = 0;
+    usize s = 0;
+    while (c < current->count && s < saved.count)
+    {
+        u64 current_fingerprint = current->entries[c].fingerprint;
+        u64 saved_fingerprint = saved.entries[s].fingerprint;
+        if (current_fingerprint < saved_fingerprint)      { added[added_count++] = current->entries[c++]; }
+        else if (current_fingerprint > saved_fingerprint) { removed[removed_count++] = saved.entries[s++]; }
+        else
+        {
+            c++;
+            s++;
+        }
+    }
+    while (c < current->count) { added[added_count++] = current->entries[c++]; }
+    while (s < saved.count) { removed[removed_count++] = saved.entries[s++]; }
+    
+    PrintBaselineChanges(current, added, added_count, "added", path);
+    PrintBaselineChanges(&saved, removed, removed_count, "removed", path);
+    
+    free(added);
+    free(removed);
+    FreeBaseline(&saved);
+    return true;
+}
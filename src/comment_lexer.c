@@ -0,0 +1,233 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// every language is a small dfa over character classes
+//     classes maps a byte to its class, anything not listed is class 0
+//     transitions[state][class] is the next state
+//     state 0 is always plain code
+// the tables are tiny so the inner loop is two loads per byte with no branches
+
+//=====================================================================================================================
+// C style, // and /* */ with "strings" and 'chars'
+//=====================================================================================================================
+enum { CClass_Other, CClass_Slash, CClass_Star, CClass_Newline, CClass_DoubleQuote, CClass_SingleQuote, CClass_Backslash };
+enum { CState_Code, CState_Slash, CState_LineComment, CState_BlockComment, CState_BlockStar, CState_String, CState_StringEscape, CState_Char, CState_CharEscape, CState_Count };
+
+static const u8 c_classes[256] = 
+{
+    ['/'] = CClass_Slash, ['*'] = CClass_Star, ['\n'] = CClass_Newline, ['"'] = CClass_DoubleQuote, ['\''] = CClass_SingleQuote, ['\\'] = CClass_Backslash
+};
+
+static const u8 c_transitions[CommentLexer_MaxStates][CommentLexer_MaxClasses] = 
+{
+    //                        Other               Slash                 Star                 Newline              DoubleQuote          SingleQuote        Backslash
+    [CState_Code]         = { CState_Code,         CState_Slash,        CState_Code,         CState_Code,         CState_String,       CState_Char,       CState_Code },
+    [CState_Slash]        = { CState_Code,         CState_LineComment,  CState_BlockComment, CState_Code,         CState_String,       CState_Char,       CState_Code },
+    [CState_LineComment]  = { CState_LineComment,  CState_LineComment,  CState_LineComment,  CState_Code,         CState_LineComment,  CState_LineComment, CState_LineComment },
+    [CState_BlockComment] = { CState_BlockComment, CState_BlockComment, CState_BlockStar,    CState_BlockComment, CState_BlockComment, CState_BlockComment, CState_BlockComment },
+    [CState_BlockStar]    = { CState_BlockComment, CState_Code,         CState_BlockStar,    CState_BlockComment, CState_BlockComment, CState_BlockComment, CState_BlockComment },
+    [CState_String]       = { CState_String,       CState_String,       CState_String,       CState_Code,         CState_Code,         CState_String,     CState_StringEscape },
+    [CState_StringEscape] = { CState_String,       CState_String,       CState_String,       CState_String,       CState_String,       CState_String,     CState_String },
+    [CState_Char]         = { CState_Char,         CState_Char,         CState_Char,         CState_Code,         CState_Char,         CState_Code,       CState_CharEscape },
+    [CState_CharEscape]   = { CState_Char,         CState_Char,         CState_Char,         CState_Char,         CState_Char,         CState_Char,       CState_Char },
+};
+
+static const bool c_is_comment[CommentLexer_MaxStates] = 
+{
+    [CState_LineComment] = true, [CState_BlockComment] = true, [CState_BlockStar] = true
+};
+
+//=====================================================================================================================
+// Hash style, python/shell/cmake/yaml... # to end of line
+//=====================================================================================================================
+enum { HashClass_Other, HashClass_Hash, HashClass_Newline, HashClass_DoubleQuote, HashClass_SingleQuote, HashClass_Backslash };
+enum { HashState_Code, HashState_Comment, HashState_String, HashState_StringEscape, HashState_Quote, HashState_QuoteEscape, HashState_Count };
+
+static const u8 hash_classes[256] = 
+{
+    ['#'] = HashClass_Hash, ['\n'] = HashClass_Newline, ['"'] = HashClass_DoubleQuote, ['\''] = HashClass_SingleQuote, ['\\'] = HashClass_Backslash
+};
+
+static const u8 hash_transitions[CommentLexer_MaxStates][CommentLexer_MaxClasses] = 
+{
+    //                           Other                 Hash                  Newline              DoubleQuote          SingleQuote          Backslash
+    [HashState_Code]         = { HashState_Code,       HashState_Comment,    HashState_Code,      HashState_String,    HashState_Quote,     HashState_Code },
+    [HashState_Comment]      = { HashState_Comment,    HashState_Comment,    HashState_Code,      HashState_Comment,   HashState_Comment,   HashState_Comment },
+    [HashState_String]       = { HashState_String,     HashState_String,     HashState_Code,      HashState_Code,      HashState_String,    HashState_StringEscape },
+    [HashState_StringEscape] = { HashState_String,     HashState_String,     HashState_String,    HashState_String,    HashState_String,    HashState_String },
+    [HashState_Quote]        = { HashState_Quote,      HashState_Quote,      HashState_Code,      HashState_Quote,     HashState_Code,      HashState_QuoteEscape },
+    [HashState_QuoteEscape]  = { HashState_Quote,      HashState_Quote,      HashState_Quote,     HashState_Quote,     HashState_Quote,     HashState_Quote },
+};
+
+static const bool hash_is_comment[CommentLexer_MaxStates] = 
+{
+    [HashState_Comment] = true
+};
+
+//=====================================================================================================================
+// Lua, -- to end of line and --[[ ]] blocks
+//=====================================================================================================================
+enum { LuaClass_Other, LuaClass_Dash, LuaClass_OpenBracket, LuaClass_CloseBracket, LuaClass_Newline, LuaClass_DoubleQuote, LuaClass_SingleQuote, LuaClass_Backslash };
+enum 
+{ 
+    LuaState_Code, LuaState_Dash, LuaState_CommentStart, LuaState_CommentBracket, LuaState_LineComment, LuaState_BlockComment, LuaState_BlockClose, 
+    LuaState_String, LuaState_StringEscape, LuaState_Quote, LuaState_QuoteEscape, LuaState_Count 
+};
+
+static const u8 lua_classes[256] = 
+{
+    ['-'] = LuaClass_Dash, ['['] = LuaClass_OpenBracket, [']'] = LuaClass_CloseBracket, ['\n'] = LuaClass_Newline, 
+    ['"'] = LuaClass_DoubleQuote, ['\''] = LuaClass_SingleQuote, ['\\'] = LuaClass_Backslash
+};
+
+static const u8 lua_transitions[CommentLexer_MaxStates][CommentLexer_MaxClasses] = 
+{
+    //                             Other                   Dash                    OpenBracket              CloseBracket            Newline                DoubleQuote             SingleQuote             Backslash
+    [LuaState_Code]            = { LuaState_Code,          LuaState_Dash,          LuaState_Code,           LuaState_Code,          LuaState_Code,         LuaState_String,        LuaState_Quote,         LuaState_Code },
+    [LuaState_Dash]            = { LuaState_Code,          LuaState_CommentStart,  LuaState_Code,           LuaState_Code,          LuaState_Code,         LuaState_String,        LuaState_Quote,         LuaState_Code },
+    [LuaState_CommentStart]    = { LuaState_LineComment,   LuaState_LineComment,   LuaState_CommentBracket, LuaState_LineComment,   LuaState_Code,         LuaState_LineComment,   LuaState_LineComment,   LuaState_LineComment },
+    [LuaState_CommentBracket]  = { LuaState_LineComment,   LuaState_LineComment,   LuaState_BlockComment,   LuaState_LineComment,   LuaState_Code,         LuaState_LineComment,   LuaState_LineComment,   LuaState_LineComment },
+    [LuaState_LineComment]     = { LuaState_LineComment,   LuaState_LineComment,   LuaState_LineComment,    LuaState_LineComment,   LuaState_Code,         LuaState_LineComment,   LuaState_LineComment,   LuaState_LineComment },
+    [LuaState_BlockComment]    = { LuaState_BlockComment,  LuaState_BlockComment,  LuaState_BlockComment,   LuaState_BlockClose,    LuaState_BlockComment, LuaState_BlockComment,  LuaState_BlockComment,  LuaState_BlockComment },
+    [LuaState_BlockClose]      = { LuaState_BlockComment,  LuaState_BlockComment,  LuaState_BlockComment,   LuaState_Code,          LuaState_BlockComment, LuaState_BlockComment,  LuaState_BlockComment,  LuaState_BlockComment },
+    [LuaState_String]          = { LuaState_String,        LuaState_String,        LuaState_String,         LuaState_String,        LuaState_Code,         LuaState_Code,          LuaState_String,        LuaState_StringEscape },
+    [LuaState_StringEscape]    = { LuaState_String,        LuaState_String,        LuaState_String,         LuaState_String,        LuaState_String,       LuaState_String,        LuaState_String,        LuaState_String },
+    [LuaState_Quote]           = { LuaState_Quote,         LuaState_Quote,         LuaState_Quote,          LuaState_Quote,         LuaState_Code,         LuaState_Quote,         LuaState_Code,          LuaState_QuoteEscape },
+    [LuaState_QuoteEscape]     = { LuaState_Quote,         LuaState_Quote,         LuaState_Quote,          LuaState_Quote,         LuaState_Quote,        LuaState_Quote,         LuaState_Quote,         LuaState_Quote },
+};
+
+static const bool lua_is_comment[CommentLexer_MaxStates] = 
+{
+    [LuaState_CommentStart] = true, [LuaState_CommentBracket] = true, [LuaState_LineComment] = true, [LuaState_BlockComment] = true, [LuaState_BlockClose] = true
+};
+
+//=====================================================================================================================
+// Markup, html/xml <!-- -->
+//=====================================================================================================================
+enum { MarkupClass_Other, MarkupClass_Open, MarkupClass_Bang, MarkupClass_Dash, MarkupClass_Close };
+enum { MarkupState_Text, MarkupState_Open, MarkupState_Bang, MarkupState_BangDash, MarkupState_Comment, MarkupState_Dash, MarkupState_DashDash, MarkupState_Count };
+
+static const u8 markup_classes[256] = 
+{
+    ['<'] = MarkupClass_Open, ['!'] = MarkupClass_Bang, ['-'] = MarkupClass_Dash, ['>'] = MarkupClass_Close
+};
+
+static const u8 markup_transitions[CommentLexer_MaxStates][CommentLexer_MaxClasses] = 
+{
+    //                         Other                 Open                  Bang                 Dash                    Close
+    [MarkupState_Text]     = { MarkupState_Text,     MarkupState_Open,     MarkupState_Text,    MarkupState_Text,       MarkupState_Text },
+    [MarkupState_Open]     = { MarkupState_Text,     MarkupState_Open,     MarkupState_Bang,    MarkupState_Text,       MarkupState_Text },
+    [MarkupState_Bang]     = { MarkupState_Text,     MarkupState_Open,     MarkupState_Text,    MarkupState_BangDash,   MarkupState_Text },
+    [MarkupState_BangDash] = { MarkupState_Text,     MarkupState_Open,     MarkupState_Text,    MarkupState_Comment,    MarkupState_Text },
+    [MarkupState_Comment]  = { MarkupState_Comment,  MarkupState_Comment,  MarkupState_Comment, MarkupState_Dash,       MarkupState_Comment },
+    [MarkupState_Dash]     = { MarkupState_Comment,  MarkupState_Comment,  MarkupState_Comment, MarkupState_DashDash,   MarkupState_Comment },
+    [MarkupState_DashDash] = { MarkupState_Comment,  MarkupState_Comment,  MarkupState_Comment, MarkupState_DashDash,   MarkupState_Text },
+};
+
+static const bool markup_is_comment[CommentLexer_MaxStates] = 
+{
+    [MarkupState_Comment] = true, [MarkupState_Dash] = true, [MarkupState_DashDash] = true
+};
+
+//=====================================================================================================================
+// Language lookup
+//=====================================================================================================================
+typedef struct CommentLanguageTables
+{
+    const u8* classes;
+    const u8 (*transitions)[CommentLexer_MaxClasses];
+    const bool* is_comment;
+} CommentLanguageTables;
+
+static const CommentLanguageTables language_tables[CommentLanguage_Count] = 
+{
+    [CommentLanguage_C]      = { c_classes,      c_transitions,      c_is_comment },
+    [CommentLanguage_Hash]   = { hash_classes,   hash_transitions,   hash_is_comment },
+    [CommentLanguage_Lua]    = { lua_classes,    lua_transitions,    lua_is_comment },
+    [CommentLanguage_Markup] = { markup_classes, markup_transitions, markup_is_comment },
+};
+
+typedef struct CommentLanguageExtension
+{
+    const char* extension;
+    CommentLanguage language;
+} CommentLanguageExtension;
+
+static const CommentLanguageExtension language_extensions[] = 
+{
+    { ".c", CommentLanguage_C }, { ".h", CommentLanguage_C }, { ".cpp", CommentLanguage_C }, { ".hpp", CommentLanguage_C }, 
+    { ".cc", CommentLanguage_C }, { ".cxx", CommentLanguage_C }, { ".hh", CommentLanguage_C }, { ".hxx", CommentLanguage_C },
+    { ".inl", CommentLanguage_C }, { ".m", CommentLanguage_C }, { ".mm", CommentLanguage_C }, { ".cs", CommentLanguage_C }, 
+    { ".java", CommentLanguage_C }, { ".js", CommentLanguage_C }, { ".ts", CommentLanguage_C }, { ".go", CommentLanguage_C }, 
+    { ".rs", CommentLanguage_C }, { ".swift", CommentLanguage_C }, { ".kt", CommentLanguage_C }, { ".glsl", CommentLanguage_C }, 
+    { ".hlsl", CommentLanguage_C }, { ".shader", CommentLanguage_C },
+    
+    { ".py", CommentLanguage_Hash }, { ".sh", CommentLanguage_Hash }, { ".bash", CommentLanguage_Hash }, { ".zsh", CommentLanguage_Hash },
+    { ".rb", CommentLanguage_Hash }, { ".pl", CommentLanguage_Hash }, { ".cmake", CommentLanguage_Hash }, { "CMakeLists.txt", CommentLanguage_Hash },
+    { "Makefile", CommentLanguage_Hash }, { ".mk", CommentLanguage_Hash }, { ".yml", CommentLanguage_Hash }, { ".yaml", CommentLanguage_Hash }, 
+    { ".toml", CommentLanguage_Hash }, { ".ps1", CommentLanguage_Hash }, { ".todo_config", CommentLanguage_Hash },
+    
+    { ".lua", CommentLanguage_Lua },
+    
+    { ".html", CommentLanguage_Markup }, { ".htm", CommentLanguage_Markup }, { ".xhtml", CommentLanguage_Markup }, 
+    { ".xml", CommentLanguage_Markup }, { ".svg", CommentLanguage_Markup },
+};
+
+CommentLanguage GetCommentLanguage(const char* filename)
+{
+    for (usize i = 0; i < ArrayCount(language_extensions); i++)
+    {
+        if (StringEndsWith(filename, language_extensions[i].extension))
+        {
+            return language_extensions[i].language;
+        }
+    }
+    return CommentLanguage_None;
+}
+
+bool CommentLexer_Init(CommentLexer* lexer, CommentLanguage language)
+{
+    memset(lexer, 0, sizeof(CommentLexer));
+    if (language <= CommentLanguage_None || language >= CommentLanguage_Count) { return false; }
+    
+    lexer->classes = language_tables[language].classes;
+    lexer->transitions = language_tables[language].transitions;
+    lexer->is_comment = language_tables[language].is_comment;
+    return true;
+}
+
+void CommentLexer_Advance(CommentLexer* lexer, const char* start, const char* end)
+{
+    u8 state = lexer->state;
+    const u8* classes = lexer->classes;
+    const u8 (*transitions)[CommentLexer_MaxClasses] = lexer->transitions;
+    for (const char* c = start; c < end; c++)
+    {
+        state = transitions[state][classes[(u8)(*c)]];
+    }
+    lexer->state = state;
+}
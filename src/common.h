@@ -34,6 +34,7 @@
     #include <windows.h>
     #include <direct.h>
     #include <io.h>
+    #include <fcntl.h>
     #define getcwd _getcwd
     #define access _access
     #define R_OK 4
@@ -43,6 +44,14 @@
     #include <dirent.h>
     #include <sys/stat.h>
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <pthread.h>
+#endif
+
+// sse2 is baseline on every x64 target, everything else uses the scalar paths
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define SIMD_SSE2
+    #include <emmintrin.h>
 #endif
 
 
@@ -58,14 +67,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <time.h>
+
+#include "todo_finder.h"
 
 
 //=====================================================================================================================
 // Basics
 //=====================================================================================================================
 typedef uint8_t u8;
+typedef int16_t s16;
+typedef uint16_t u16;
 typedef int32_t s32;
+typedef int64_t s64;
 typedef uint32_t u32;
+typedef uint64_t u64;
 typedef size_t usize;
 
 #define ArrayCount(array) (sizeof(array)/sizeof(array[0]))
@@ -87,22 +103,136 @@ typedef void(*ExitFunction)();
 void RegisterExitFunction(ExitFunction function, const char *name, const char *file);
 void Terminate(s32 exit_code, const char *file);
 
+//=====================================================================================================================
+// Time
+//=====================================================================================================================
+// monotonic, only good for measuring how long something took
+u64 GetTimeMilliseconds();
+
+//=====================================================================================================================
+// Threads
+//=====================================================================================================================
+// just enough to run a function on another thread and wait for it, the Thread has to outlive the thread
+typedef void (*ThreadFunction)(void* data);
+typedef struct Thread
+{
+#ifdef OS_Win32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    ThreadFunction function;
+    void* data;
+    bool started;
+} Thread;
+
+bool Thread_Start(Thread* thread, ThreadFunction function, void* data);
+void Thread_Join(Thread* thread);
+void Thread_Sleep(u32 milliseconds);
+usize GetProcessorCount(); // cores the os will run us on, at least 1
+
+// acquire/release is all the single producer single consumer queues need
+// x64 only reorders stores after loads, so on msvc a compiler barrier is enough for these two
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define ThreadLocal __declspec(thread)
+    static inline u32 AtomicLoadAcquire(volatile u32* value) { u32 result = *value; _ReadWriteBarrier(); return result; }
+    static inline void AtomicStoreRelease(volatile u32* value, u32 new_value) { _ReadWriteBarrier(); *value = new_value; }
+    static inline void* AtomicLoadAcquirePointer(void* volatile* value) { void* result = *value; _ReadWriteBarrier(); return result; }
+    static inline bool AtomicCompareExchangePointer(void* volatile* target, void* expected, void* desired) 
+    { 
+        return InterlockedCompareExchangePointer(target, desired, expected) == expected; 
+    }
+    static inline bool AtomicCompareExchange(volatile u32* target, u32 expected, u32 desired) 
+    { 
+        return (u32)(InterlockedCompareExchange((volatile LONG*)(target), (LONG)(desired), (LONG)(expected))) == expected; 
+    }
+    static inline u64 AtomicAdd64(volatile u64* target, u64 amount) 
+    { 
+        return (u64)(InterlockedExchangeAdd64((volatile LONG64*)(target), (LONG64)(amount))) + amount; 
+    }
+    static inline void AtomicMax64(volatile u64* target, u64 value)
+    {
+        u64 current = *target;
+        while (current < value)
+        {
+            u64 seen = (u64)(InterlockedCompareExchange64((volatile LONG64*)(target), (LONG64)(value), (LONG64)(current)));
+            if (seen == current) { break; }
+            current = seen;
+        }
+    }
+#else
+    #define ThreadLocal _Thread_local
+    static inline u32 AtomicLoadAcquire(volatile u32* value) { return __atomic_load_n(value, __ATOMIC_ACQUIRE); }
+    static inline void AtomicStoreRelease(volatile u32* value, u32 new_value) { __atomic_store_n(value, new_value, __ATOMIC_RELEASE); }
+    static inline void* AtomicLoadAcquirePointer(void* volatile* value) { return __atomic_load_n(value, __ATOMIC_ACQUIRE); }
+    static inline bool AtomicCompareExchangePointer(void* volatile* target, void* expected, void* desired) 
+    { 
+        return __atomic_compare_exchange_n(target, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); 
+    }
+    static inline bool AtomicCompareExchange(volatile u32* target, u32 expected, u32 desired) 
+    { 
+        return __atomic_compare_exchange_n(target, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); 
+    }
+    static inline u64 AtomicAdd64(volatile u64* target, u64 amount) { return __atomic_add_fetch(target, amount, __ATOMIC_RELAXED); }
+    static inline void AtomicMax64(volatile u64* target, u64 value)
+    {
+        u64 current = __atomic_load_n(target, __ATOMIC_RELAXED);
+        while (current < value && !__atomic_compare_exchange_n(target, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+    }
+#endif
+
 //=====================================================================================================================
 // Logger
 //=====================================================================================================================
+// every thread formats into its own ring, one writer thread empties them into stdout and the log file
+// the level is read without a lock, set it before starting any threads
+// a disabled LogDebug is one compare, the arguments aren't evaluated, so it's left in release builds
+typedef enum LogLevel
+{
+    LogLevel_Info,  // Log, the report and errors
+    LogLevel_Debug, // LogDebug, on by default in debug builds, --log-level debug otherwise
+} LogLevel;
+
 static const char* log_file_name = "todo_output.txt";
+extern s32 log_level;
 void LogMessage(const char* format, ...);
+bool ParseLogLevel(const char* name, s32* level);
+void ReleaseThreadLogRing(); // called by a Thread_Start thread on its way out, the next thread to log reuses its ring
 #define Log(format, ...) LogMessage(format, ##__VA_ARGS__) 
-#ifdef NDEBUG
-    #define LogDebug(format, ...) ((void)(0))
-#else
-    #define LogDebug(format, ...) LogMessage(format, ##__VA_ARGS__) 
-#endif 
+#define LogDebug(format, ...) ((log_level >= LogLevel_Debug) ? LogMessage(format, ##__VA_ARGS__) : (void)(0))
 
 
 //=====================================================================================================================
 // Allocator
 //=====================================================================================================================
+// --mem-stats, heap memory is counted against the subsystem that asked for it
+// built with -DTRACK_ALLOCATIONS every block gets a small header with its size and tag, otherwise these are plain malloc and free
+// a block has to be freed through the same layer it came from
+typedef enum AllocationTag
+{
+    AllocationTag_FileContents, // file read buffers, stream carry and decompression state
+    AllocationTag_StringVector, // the vectors and every string pushed into them, messages included
+    AllocationTag_MessageTable, // patterns, trie, buckets, visited set, walk stack, rollup and match locations
+    AllocationTag_Count,
+} AllocationTag;
+
+#ifdef TRACK_ALLOCATIONS
+void* TrackedMalloc(AllocationTag tag, usize size);
+void* TrackedCalloc(AllocationTag tag, usize count, usize size);
+void* TrackedRealloc(AllocationTag tag, void* memory, usize size);
+void  TrackedFree(void* memory);
+#define TaggedMalloc(tag, size)          TrackedMalloc(tag, size)
+#define TaggedCalloc(tag, count, size)   TrackedCalloc(tag, count, size)
+#define TaggedRealloc(tag, memory, size) TrackedRealloc(tag, memory, size)
+#define TaggedFree(memory)               TrackedFree(memory)
+#else
+#define TaggedMalloc(tag, size)          malloc(size)
+#define TaggedCalloc(tag, count, size)   calloc(count, size)
+#define TaggedRealloc(tag, memory, size) realloc(memory, size)
+#define TaggedFree(memory)               free(memory)
+#endif
+void PrintAllocationStats();
+
 // basic static size heap memory buffer
 // crashes on failure
 typedef struct MemoryBuffer 
@@ -110,7 +240,7 @@ typedef struct MemoryBuffer
     char* buffer;
     usize size;
 } MemoryBuffer;
-void Allocate(MemoryBuffer* memory, usize bytes); 
+void Allocate(MemoryBuffer* memory, usize bytes); // tagged as file contents, the only thing that reads whole files
 void Free(MemoryBuffer* memory); 
 
 
@@ -129,7 +259,19 @@ bool  FileOpen(File* file, const char* filename, const char* mode);
 usize FileWrite(MemoryBuffer* data, usize byte_count, File* file);
 usize FileRead(MemoryBuffer* destination, usize byte_count, File* file);
 usize FilePuts(const char* string, File* file);
+usize FileReadAt(File* file, u64 offset, void* destination, usize byte_count); // pread, doesn't care where the file position is
+void  PrefetchFile(const char* filename); // asks the os to start reading the file into the page cache, returns right away
 void  FileClose(File* file);
+bool  FileOpenStandardInput(File* file); // stdin as a File to read from, FileClose leaves stdin open
+
+// one buffer a scanner reads every file into, grown to the biggest file so far
+// once a file bigger than ReadBufferKeepSize is done it is let go, one huge file doesn't pin that much memory for the rest of the scan
+#define ReadBufferKeepSize (4 * 1024 * 1024)
+typedef struct ReadBuffer
+{
+    MemoryBuffer memory;
+} ReadBuffer;
+void FreeReadBuffer(ReadBuffer* read_buffer);
 
 // Dont bother with file streaming
 // just read it all into a buffer
@@ -138,10 +280,63 @@ typedef struct FileContents
 {
     char path[MaxPath];
     MemoryBuffer memory;    
+    ReadBuffer* borrowed_from; // set when memory belongs to a ReadBuffer, FreeFileContents hands it back
 } FileContents;
 usize GetFileContents(FileContents* file_contents, const char* filepath);
+// size_hint is the size the directory walk saw, 0 when it isn't known
+// on posix that makes a load open, one read and close, see ReadWholeFile
+usize GetFileContentsReusing(FileContents* file_contents, const char* filepath, u64 size_hint, ReadBuffer* read_buffer); // only one file per ReadBuffer at a time
+usize GetStandardInputContents(FileContents* file_contents); // reads stdin until it closes
 void  FreeFileContents(FileContents* file_contents);
 
+// streaming gzip reader, memory is the 32k window plus a small input buffer no matter how big the file is
+// GzipRead returns 0 at the end of the stream or when it is broken, error tells them apart
+#define InflateFastBits 10
+
+typedef struct InflateHuffman
+{
+    u16 counts[16];
+    u16 symbols[288];
+    u16 fast[1 << InflateFastBits];
+} InflateHuffman;
+
+typedef enum InflateState
+{
+    InflateState_BlockHeader,
+    InflateState_Stored,
+    InflateState_Huffman,
+    InflateState_BlockEnd,
+} InflateState;
+
+typedef struct GzipReader
+{
+    File file;
+    u8 input[16384];
+    usize input_size;
+    usize input_position;
+    u64 bit_buffer;
+    u32 bit_count;
+    u32 padding_bits;
+    
+    InflateState state;
+    bool last_block;
+    u32 stored_remaining;
+    InflateHuffman literals;
+    InflateHuffman distances;
+    
+    u8 window[32768];
+    u64 write_total;
+    u64 read_total;
+    u64 member_start;
+    u32 crc;
+    bool finished;
+    bool error; // corrupt, truncated or the trailer's crc32 or size didn't match, callers report it
+} GzipReader;
+
+bool  GzipOpen(GzipReader* reader, const char* path);
+usize GzipRead(GzipReader* reader, u8* destination, usize count);
+void  GzipClose(GzipReader* reader);
+
 //=====================================================================================================================
 // Directories
 //=====================================================================================================================
@@ -165,14 +360,23 @@ typedef struct
 #define PERMISSIONS_EXISTS 0x08
 
 bool GetCurrentDirectoryInfo(DirectoryInfo* directory);
+FileType GetPathType(const char* path); // FileType_Other when the path doesn't exist
 
 typedef struct 
 {
     const char* name;
     FileType type;
     char path[MaxPath];
+    u64 device; // device and inode are 0 when the platform can't tell us cheaply
+    u64 inode;
+    u64 modified_time; // only good for ordering, the units are whatever the platform uses
+    u64 size;          // handed to the loader so it doesn't have to ask again
+    u32 link_count;    // names the file has, reaching it through a symlink counts as one more
 } DirectoryEntry;
 
+// follows symlinks, fills type, device, inode, modified time and size, false when the path doesn't exist
+bool GetPathInfo(const char* path, DirectoryEntry* entry);
+
 typedef struct 
 {
     char text_buffer[MaxPath];
@@ -188,10 +392,64 @@ typedef struct
 
 } DirectoryIterator;
 
+// every entry of one directory read in one go, so its handle is closed before anything under it is opened
+// the names share one pool, "." and ".." are left out, type, device, inode, time and size are the same as DirectoryEntry's
+typedef struct DirectoryListingEntry
+{
+    u32 name_offset;
+    u32 name_length;
+    FileType type;
+    u64 device;
+    u64 inode;
+    u64 modified_time;
+    u64 size;
+    u32 link_count; // see DirectoryEntry
+} DirectoryListingEntry;
+
+typedef struct DirectoryListing
+{
+    DirectoryListingEntry* entries;
+    usize count;
+    usize capacity;
+    char* names;
+    usize names_size;
+    usize names_capacity;
+} DirectoryListing;
+
+// path is a MaxPath buffer ending in the directory at path_length, on win32 it is extended and put back to look at subdirectories
+// the listing is emptied first and keeps its memory, false when the directory can't be opened
+bool DirectoryList(DirectoryListing* listing, char* path, usize path_length);
+void DirectoryListing_Free(DirectoryListing* listing);
+
 bool DirectoryOpen(DirectoryIterator* iter, const char* directory);
 bool DirectoryNextEntry(DirectoryIterator* directory_iterator, DirectoryEntry* entry);
 void DirectoryClose(DirectoryIterator* iter);
 
+// tar archives read front to back from any stream, no seeking and no temporary files
+// call TarNextMember then TarReadMember until it returns 0, unread data is skipped for you
+typedef usize (*StreamReadFunction)(void* stream, u8* destination, usize count);
+
+typedef struct TarMember
+{
+    char path[MaxPath];
+    u64 size;
+    FileType type;
+} TarMember;
+
+typedef struct TarReader
+{
+    StreamReadFunction read;
+    void* stream;
+    u64 remaining; // unread bytes of the current member
+    u64 padding;   // zeros after the member up to the next 512 byte block
+    bool finished;
+    bool error;
+} TarReader;
+
+void  TarOpen(TarReader* reader, StreamReadFunction read, void* stream);
+bool  TarNextMember(TarReader* reader, TarMember* member);
+usize TarReadMember(TarReader* reader, u8* destination, usize count);
+
 //=====================================================================================================================
 // C Strings
 //=====================================================================================================================
@@ -200,6 +458,30 @@ usize StringLength(const char *string);
 s32 StringCompare(const char *left, const char* right);
 bool StringEndsWith(const char *string, const char* suffix);
 
+// ascii only case folding, everything outside A-Z is left alone
+static inline char FoldCase(char c) { return (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : c; }
+
+// search kernels, they work on [start, end) and never read past end
+// FindFirstOfBytes returns end when none of the bytes are found
+// StringMatchesFolded compares text against an already folded pattern, folding text as it goes
+//     available is how many bytes of text can be read, folded_pattern must be zero padded to a multiple of 16
+const char* FindFirstOfBytes(const char* start, const char* end, const u8* bytes, usize byte_count);
+bool StringMatchesFolded(const char* text, usize available, const char* folded_pattern, usize length);
+
+// utf-16 text, DetectUtf16 looks for a bom, or for every other byte being zero near the start of the file
+// bom_size is how many bytes to skip before the text starts
+// TranscodeUtf16 converts whole code units from [*source, source_end) into at most destination_size bytes of utf-8
+//     *source is moved past what was used, a surrogate pair is never split, unpaired surrogates become U+FFFD
+typedef enum Utf16Order
+{
+    Utf16Order_None,
+    Utf16Order_LittleEndian,
+    Utf16Order_BigEndian,
+} Utf16Order;
+
+Utf16Order DetectUtf16(const u8* data, usize size, usize* bom_size);
+usize TranscodeUtf16(const u8** source, const u8* source_end, Utf16Order order, char* destination, usize destination_size);
+
 // Array of c strings
 // crashes on failure
 typedef struct StringVector
@@ -214,6 +496,116 @@ void StringVector_PushArray(StringVector* vec, const char** array, usize count);
 void StringVector_Free(StringVector* vec);
 void StringVector_Sort(StringVector* vec);
 
+//=====================================================================================================================
+// Comment Lexer
+//=====================================================================================================================
+// table driven state machines that know when a byte is inside a comment
+// picked by file extension, files without a language are searched everywhere
+// the lexer only moves forward, Advance it over everything before the byte you want to ask about
+typedef enum CommentLanguage
+{
+    CommentLanguage_None,
+    CommentLanguage_C,      // // and /* */
+    CommentLanguage_Hash,   // # python, shell, cmake, yaml...
+    CommentLanguage_Lua,    // -- and --[[ ]]
+    CommentLanguage_Markup, // <!-- -->
+    CommentLanguage_Count
+} CommentLanguage;
+
+#define CommentLexer_MaxStates 16
+#define CommentLexer_MaxClasses 8
+
+typedef struct CommentLexer
+{
+    const u8* classes;
+    const u8 (*transitions)[CommentLexer_MaxClasses];
+    const bool* is_comment;
+    u8 state;
+} CommentLexer;
+
+CommentLanguage GetCommentLanguage(const char* filename);
+bool CommentLexer_Init(CommentLexer* lexer, CommentLanguage language); // false when there is no lexer for the language
+void CommentLexer_Advance(CommentLexer* lexer, const char* start, const char* end);
+static inline bool CommentLexer_InComment(CommentLexer* lexer) { return lexer->is_comment[lexer->state]; }
+
+//=====================================================================================================================
+// Regex
+//=====================================================================================================================
+// a set of patterns compiled once into a dfa, RegexSet_Find is one table lookup per byte
+// RegexSet_Match reruns a single pattern to get where it starts and what its groups captured
+#define RegexMaxPatterns 32
+#define RegexMaxGroups 9
+#define RegexMaxDfaStates 4096
+
+typedef struct RegexByteSet
+{
+    u32 bits[8];
+} RegexByteSet;
+
+typedef enum RegexOp
+{
+    RegexOp_Class, // consume a byte in classes[x]
+    RegexOp_Split, // try x then y
+    RegexOp_Jump,  // go to x
+    RegexOp_Save,  // remember the position in slot x
+    RegexOp_Match, // pattern x matched
+} RegexOp;
+
+typedef struct RegexInstruction
+{
+    RegexOp op;
+    s32 x;
+    s32 y;
+} RegexInstruction;
+
+// what RegexSet_Match works in, made once for a program so matching a line doesn't allocate
+// seen is stamped with generation instead of cleared, one scratch is only ever used by one thread at a time
+typedef struct RegexScratch
+{
+    struct RegexThread* threads; // two lists of instruction_count each
+    u32* seen;
+    u32 generation;
+} RegexScratch;
+
+typedef struct RegexSet
+{
+    // nfa, shared by every pattern
+    RegexByteSet* classes;
+    usize class_count;
+    usize class_capacity;
+    RegexInstruction* program;
+    usize instruction_count;
+    usize instruction_capacity;
+    s32* pattern_entries;
+    s32* pattern_group_counts;
+    usize pattern_count;
+    
+    // dfa, transitions[state * byte_class_count + byte_class[byte]]
+    u16 byte_class[256];
+    u8 byte_class_representative[256];
+    usize byte_class_count;
+    s32* transitions;
+    u32* accept; // bit per pattern that has matched by the time we reach the state
+    usize state_count;
+    
+    RegexScratch scratch; // for the thread that compiled the set, others bring their own
+} RegexSet;
+
+typedef struct RegexMatch
+{
+    const char* start;
+    const char* end;
+    usize group_count;
+    const char* saved[RegexMaxGroups * 2 + 2]; // group n is [saved[2n], saved[2n + 1]), null if it didn't take part
+} RegexMatch;
+
+bool RegexSet_Compile(RegexSet* set, const char** patterns, usize pattern_count, char* error, usize error_size);
+void RegexSet_Free(RegexSet* set);
+s32  RegexSet_Find(RegexSet* set, const char* start, const char* end); // first pattern to complete a match, -1 if none
+bool RegexSet_Match(RegexSet* set, RegexScratch* scratch, s32 pattern, const char* start, const char* end, RegexMatch* match);
+bool RegexScratch_Init(RegexScratch* scratch, RegexSet* set);
+void RegexScratch_Free(RegexScratch* scratch);
+
 //=====================================================================================================================
 // User Configuration
 //=====================================================================================================================
@@ -222,25 +614,176 @@ typedef struct UserConfig
     char path[MaxPath];
     StringVector symbols;
     StringVector keywords;
+    StringVector case_insensitive_keywords;
+    StringVector regex_patterns;
     StringVector ignore_directories;
     StringVector ignore_extensions;
 }UserConfig;
-UserConfig* GetUserConfig();
+UserConfig* GetUserConfig();                // looks for a .todo_config in the working directory
+UserConfig* LoadUserConfig(const char* path);
+bool        IsUserConfigUsable(UserConfig* user_config); // logs why when a config has nothing to search for
+void        FreeUserConfig(UserConfig* user_config);     // only for a config that never made it into a MessageTable
+
+//=====================================================================================================================
+// User Arguments
+//=====================================================================================================================
+// everything the command line can ask for
+// zeroed arguments mean a normal full scan
+typedef struct UserArguments
+{
+    const char* fail_on_keyword; // stop at the first match of this keyword and exit non-zero
+    usize max_results;           // stop after this many matches, 0 means no limit
+    bool count_only;             // keep per bucket counters, never build message strings
+    bool rollup;                 // aggregate match counts per directory
+    usize rollup_depth;          // deepest directory level printed in the rollup tree, 0 is the root
+    bool comments_only;          // only match inside comments for languages that have a comment lexer
+    StringVector roots;          // directories and files to search, "." when empty
+    const char* files_from;      // file with a list of paths to search, "-" is stdin
+    bool one_file_system;        // don't descend into directories on another device than their root
+    bool mem_stats;               // print allocation counts per subsystem after the report, needs TRACK_ALLOCATIONS
+    usize context_lines;         // lines shown before and after each match, read back from the file at print time
+    usize shard_index;           // --shard i/N, only files whose path hashes to shard_index are searched
+    usize shard_count;           // 0 when not sharding
+    const char* emit_partial;    // write the results to this file for a later --merge instead of printing them
+    bool merge;                  // roots are partial results files to merge into one report, nothing is searched
+    bool inode_order;            // search each directory's files in inode order with readahead, for cold caches and spinning disks
+    u64 deadline_ms;             // 0 for no deadline, otherwise every file is found first and the newest are searched until time runs out
+    const char* save_baseline;   // write every match's fingerprint here after the scan
+    const char* diff_baseline;   // only report the matches added or removed since this baseline was saved
+    const char* diff;            // a unified diff to search the added lines of, "-" is stdin, nothing else is searched
+    const char* log_level;       // checked when parsed, main sets the process wide log_level from it, the library rejects it
+}UserArguments;
+
+// returns false on bad arguments, the reason is already logged
+bool ParseUserArguments(UserArguments* arguments, s32 argc, char** argv);
+void PrintUsage();
 
 //=====================================================================================================================
 // Message Table
 //=====================================================================================================================
+// bucket indexes are laid out symbol major, then one per regex pattern at the end
+// regex pattern buckets have symbol -1 and keyword set to the pattern index
+// a bucket is only made the first time its combination is hit, see FindBucket
 typedef struct MessageBucket
 {
+    usize index;
     s32 symbol;
     s32 keyword;
+    usize count; // matches seen, valid even when strings are not being kept
     StringVector strings;
 } MessageBucket;
+
+// one [symbol][keyword] combination, built once when the table is allocated
+// case insensitive patterns are stored folded to lower case
+typedef struct SearchPattern
+{
+    char* text; // in MessageTable.pattern_text, nul terminated
+    usize length;
+    s32 symbol;
+    s32 keyword;
+    bool case_insensitive;
+} SearchPattern;
+
+// large vocabularies share one trie instead of checking every pattern at every candidate
+// edges live in a hash keyed by (node, byte) so a node with thousands of children costs the same as one with two
+typedef struct PatternTrieEdge
+{
+    u32 from;
+    u32 to; // 0 for an empty slot, the roots are never a target
+    u8 byte;
+} PatternTrieEdge;
+
+typedef struct PatternTrie
+{
+    s32* node_patterns; // lowest pattern index that ends at each node, -1 for none
+    usize node_count;
+    usize node_capacity;
+    PatternTrieEdge* edges;
+    usize edge_count;
+    usize edge_capacity;
+} PatternTrie;
+
+// match counts for everything below one directory
+// counts has one entry per message bucket
+typedef struct RollupNode
+{
+    char* path;
+    usize depth;
+    usize total;
+    usize* counts;
+} RollupNode;
+    
+// where a kept message came from, context lines are read back from here when printing
+// message is the index into the bucket's strings, which only holds until they are sorted
+typedef struct MatchLocation
+{
+    u32 bucket;
+    u32 message;
+    u32 file; // index into context_files
+    s32 line_number;
+    u64 line_offset;
+} MatchLocation;
+
+// files waiting to be searched, --inode-order sorts them by inode and --deadline by modified time
+typedef struct FileBatchEntry
+{
+    char* path;
+    u64 inode;
+    u64 modified_time;
+    u64 size;
+} FileBatchEntry;
+
+typedef struct FileBatch
+{
+    FileBatchEntry* entries;
+    usize count;
+    usize capacity;
+    bool has_inodes; // windows listings leave every inode 0
+} FileBatch;
+
+// --save-baseline and --diff-baseline, one entry per match
+// no line number in the fingerprint so the set survives code moving around, a match is its path, keyword and text
+// text is the line from the symbol on with whitespace runs collapsed, the pool holds the strings for reporting
+typedef struct BaselineEntry
+{
+    u64 fingerprint; // path, bucket name and text hashes mixed together
+    u32 name_offset; // into the pool, consecutive matches share their path and name
+    u32 path_offset;
+    u32 text_offset;
+    s32 line_number; // only known for matches from this run, 0 when loaded from a file
+} BaselineEntry;
+
+typedef struct Baseline
+{
+    BaselineEntry* entries;
+    usize count;
+    usize capacity;
+    char* pool;
+    usize pool_size;
+    usize pool_capacity;
+    usize last_bucket; // bucket index + 1 of the last entry's name, 0 for none
+    u64 last_name_hash;
+    u64 last_path_hash;
+} Baseline;
+
+// (device, inode) pairs that were already searched, open addressing with (0, 0) as the empty slot
+// keeps symlinks and hard links from searching the same thing twice and symlink loops from recursing forever
+typedef struct VisitedSet
+{
+    u64* slots; // device, inode pairs
+    usize capacity;
+    usize count;
+} VisitedSet;
     
 typedef struct MessageTable
 {
-    // table data
+    // table data, only the buckets that were hit
+    // bucket_slots maps a bucket index to its place in message_buckets + 1, open addressing with 0 as the empty slot
     MessageBucket* message_buckets;
+    usize message_bucket_count;
+    usize message_bucket_capacity;
+    u32* bucket_slots;
+    usize bucket_slot_capacity;
     
     // from user config
     // @todo:: replace with UserConfig? it makes the syntax longer for lookup...
@@ -248,8 +791,74 @@ typedef struct MessageTable
     StringVector keywords;
     StringVector ignore_directories;
     StringVector ignore_extensions;
+    bool* keyword_case_insensitive; // one per keyword
     //
     
+    StringVector regex_patterns;
+    RegexSet regex_set;
+    usize bucket_count; // symbols * keywords + regex patterns
+    
+    // matcher, every pattern starts with one of the symbol_first_bytes
+    SearchPattern* patterns;
+    usize pattern_count;
+    char* pattern_text; // every pattern's text in one block, sized from the symbol and keyword lengths
+    u8 symbol_first_bytes[256];
+    usize symbol_first_byte_count;
+    bool use_baked_matcher; // built with TODO_BAKED_MATCHER and the loaded config is the one that was baked
+    
+    // more than LargeVocabularyPatterns patterns, they are matched through the trie and empty buckets aren't printed
+    // node 0 is the root of the case sensitive patterns, node 1 of the case insensitive ones which are walked folded
+    bool large_vocabulary;
+    PatternTrie trie;
+    
+    // from user arguments
+    UserArguments arguments;
+    s32 fail_on_keyword_index; // -1 when --fail-on is not used
+    
+    // scan state
+    // stop_requested is checked per line and per directory entry to cancel the scan early
+    usize match_count;
+    bool stop_requested;
+    bool scan_failed; // a directory couldn't be opened, the scan stops and the request fails
+    s32 exit_code;
+    
+    // library scans hand every match to the callback instead of keeping message strings
+    TodoFinderMatchCallback match_callback;
+    void* match_user_data;
+    
+    // rollup, only used with --rollup-depth
+    // rollup_counts belongs to the directory currently being walked and is added to its parent when the walk pops it
+    usize* rollup_counts;
+    usize rollup_current_depth;
+    RollupNode* rollup_nodes;
+    usize rollup_node_count;
+    usize rollup_node_capacity;
+    
+    // traversal, every directory and file is searched once no matter how many links reach it
+    VisitedSet visited;
+    u64 root_device;
+    usize deduplicated_count;
+    usize other_file_system_count;
+    
+    // --deadline, files are queued while walking and searched newest first once the walk is done
+    FileBatch deadline_files;
+    u64 deadline_end_ms;
+    bool deadline_reached;
+    bool deadline_walk_incomplete; // ran out of time before every directory was read
+    usize deadline_unsearched_count;
+    
+    // every regular file is read into this, the per file cost is the read and not a malloc, fresh page faults and a free
+    ReadBuffer read_buffer;
+    
+    // --save-baseline and --diff-baseline, every match this run found
+    Baseline baseline;
+    
+    // -C, filled in while scanning so nothing has to be kept in memory or searched again
+    MatchLocation* match_locations;
+    usize match_location_count;
+    usize match_location_capacity;
+    StringVector context_files;
+    
     // results
     StringVector skipped_directories;
     StringVector skipped_files;
@@ -261,18 +870,49 @@ typedef struct MessageTable
 MessageTable* AllocateMessageTable(UserConfig* user_config);
 void FreeMessageTable(MessageTable* message_table);
 
-// fill the message table based 
-void ProcessUserRequest(MessageTable* message_table, s32 argc, char** argv);
+// hash of [symbols], [keywords] and their case flags in table order
+// tools/generate_matcher.c bakes it into the binary so the baked matcher is only used for the config it was made from
+u64 GetMatcherFingerprint(MessageTable* message_table);
+
+// FindBucket returns 0 until a bucket's combination was hit, AddBucket makes it then, 0 when out of memory
+// pointers from either only hold until the next AddBucket
+// SortBuckets puts message_buckets in bucket index order for printing and writing
+MessageBucket* FindBucket(MessageTable* message_table, usize bucket_index);
+MessageBucket* AddBucket(MessageTable* message_table, usize bucket_index);
+void SortBuckets(MessageTable* message_table);
+
+// fill the message table based on message_table->arguments, see ParseUserArguments
+// false when the arguments don't fit the config or the scan failed, nothing is printed
+bool ProcessUserRequest(MessageTable* message_table);
 
 // what user request is calling with your desired input
-void ProcessFile(MessageTable* message_table, const char* file);
+void ProcessFile(MessageTable* message_table, const char* file, u64 size_hint); // size_hint from the walk, 0 when unknown
 void ProcessDirectory(MessageTable* message_table, const char* directory);
+void ProcessPath(MessageTable* message_table, const char* path);             // file or directory, no ignore rules
+void ProcessFileList(MessageTable* message_table, FileContents* file_list);  // nul or newline separated paths
+void ProcessDeadlineFiles(MessageTable* message_table);                      // --deadline, searches the queued files newest first
+void ProcessUnifiedDiff(MessageTable* message_table, File* diff);             // --diff, only the added lines, streamed
+
+// --shard, --emit-partial and --merge
+// partial files hold each bucket's messages sorted, merging them needs the same config that wrote them
+bool WritePartialResults(MessageTable* message_table, const char* path);
+bool MergePartialResults(MessageTable* message_table, StringVector* paths);
+void AttachContextLines(MessageTable* message_table); // -C, only does anything the first time
+void GetBucketName(MessageTable* message_table, usize bucket_index, char* name, usize name_size); // [symbol][keyword] or the pattern
+
+// --save-baseline and --diff-baseline
+// the diff sorts both sides by fingerprint and walks them together, matches are counted so duplicates pair up one to one
+void AddBaselineEntry(MessageTable* message_table, usize bucket_index, const char* path, s32 line_number, const char* text, usize text_length);
+bool SaveBaseline(MessageTable* message_table, const char* path);
+bool PrintBaselineDiff(MessageTable* message_table, const char* path);
+void FreeBaseline(Baseline* baseline);
 
 void PrintSearchPatterns(MessageTable* message_table);
 void PrintIgnoredDirectories(MessageTable* message_table);
 void PrintIgnoredFiles(MessageTable* message_table);
 void PrintEmptyFiles(MessageTable* message_table);
 void PrintMessages(MessageTable* message_table);
+void PrintRollup(MessageTable* message_table);
 
 //=====================================================================================================================
 #endif // COMMON_H
@@ -37,7 +37,7 @@ void RegisterExitFunction(ExitFunction function, const char *name, const char *f
     exit_functions[exit_function_count] = function;
     exit_function_count++;
 
-    LogDebug("Exit Function registered: %s, %s", name, file);
+    LogDebug("Exit Function registered: %s, %s\n", name, file);
 }
 
 // this function does not return
@@ -50,6 +50,9 @@ void Terminate(s32 exit_code, const char *file)
             exit_functions[i]();
         }
     }
+    
+    // neither exit path below flushes stdio, piped output would be lost
+    fflush(stdout);
 
 #ifdef OS_Win32
     u32 code = (u32)(exit_code); // just let -1 get cast to u32, it will show up as 4294967295
@@ -91,6 +91,47 @@ usize FileRead(MemoryBuffer* destination, usize byte_count, File* file)
     return size;
 }
 
+usize FileReadAt(File* file, u64 offset, void* destination, usize byte_count)
+{
+    if (!file || !file->fp) 
+    {
+        LogDebug("FileReadAt, File structure has null FILE ptr.\n"); 
+        return 0;
+    }
+    
+#ifdef OS_Win32
+    if (_fseeki64(file->fp, (s64)(offset), SEEK_SET) != 0) { return 0; }
+    return fread(destination, 1, byte_count, file->fp);
+#else
+    s32 descriptor = fileno(file->fp);
+    usize total = 0;
+    while (total < byte_count)
+    {
+        ssize_t read = pread(descriptor, (char*)(destination) + total, byte_count - total, (off_t)(offset + total));
+        if (read < 0 && errno == EINTR) { continue; }
+        if (read <= 0) { break; }
+        total += (usize)(read);
+    }
+    return total;
+#endif
+}
+
+void PrefetchFile(const char* filename)
+{
+#if defined(OS_Win32)
+    // nothing cheap to ask for without mapping the file
+    (void)(filename);
+#else
+    s32 descriptor = open(filename, O_RDONLY);
+    if (descriptor < 0) { return; }
+    
+    #ifdef POSIX_FADV_WILLNEED
+        posix_fadvise(descriptor, 0, 0, POSIX_FADV_WILLNEED);
+    #endif
+    close(descriptor);
+#endif
+}
+
 usize FilePuts(const char* string, File* file)
 {
     if (!file)
@@ -128,10 +169,132 @@ void FileClose(File* file)
         LogDebug("FileClose, filepath: %.*s\n", ArrayCount(file->path), file->path); 
         return;
     }
-    fclose(file->fp);
+    if(file->fp != stdin) { fclose(file->fp); }
+}
+
+bool FileOpenStandardInput(File* file)
+{
+    if (!file)
+    {
+        LogDebug("FileOpenStandardInput given null File structure.\n"); 
+        return false;
+    }
+    
+#ifdef OS_Win32
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    file->fp = stdin;
+    StringCopy_NullTerminate(file->mode, "rb", sizeof(file->mode));
+    StringCopy_NullTerminate(file->path, "stdin", sizeof(file->path));
+    return true;
 }
 
 usize GetFileContents(FileContents* file_contents, const char* filepath) 
+{
+    return GetFileContentsReusing(file_contents, filepath, 0, 0);
+}
+
+// room for size bytes plus the nul
+// the first keep bytes survive the move, with nothing to keep it's a free and malloc instead of a realloc copy
+static bool ReserveReadBuffer(ReadBuffer* read_buffer, usize size, usize keep)
+{
+    if (read_buffer->memory.buffer && read_buffer->memory.size >= size + 1) { return true; }
+    
+    usize capacity = read_buffer->memory.size ? read_buffer->memory.size : 64 * 1024;
+    while (capacity < size + 1) { capacity *= 2; }
+    if (keep)
+    {
+        char* new_buffer = (char*)(TaggedRealloc(AllocationTag_FileContents, read_buffer->memory.buffer, capacity));
+        if (!new_buffer) { return false; }
+        read_buffer->memory.buffer = new_buffer;
+        read_buffer->memory.size = capacity;
+        return true;
+    }
+    
+    FreeReadBuffer(read_buffer);
+    read_buffer->memory.buffer = (char*)(TaggedMalloc(AllocationTag_FileContents, capacity));
+    if (!read_buffer->memory.buffer) { return false; }
+    read_buffer->memory.size = capacity;
+    return true;
+}
+
+void FreeReadBuffer(ReadBuffer* read_buffer)
+{
+    if (read_buffer && read_buffer->memory.buffer)
+    {
+        Free(&read_buffer->memory);
+        read_buffer->memory.buffer = 0;
+    }
+}
+
+// the buffer stays for the next file unless the last one made it bigger than it is worth keeping
+static void ReleaseReadBuffer(ReadBuffer* read_buffer)
+{
+    if (read_buffer->memory.size > ReadBufferKeepSize) { FreeReadBuffer(read_buffer); }
+}
+
+#ifndef OS_Win32
+#ifndef O_NOATIME
+    #define O_NOATIME 0
+#endif
+
+// open, read and close, no stdio and usually nothing else
+// with a size_hint the buffer has room for one byte more than the walk saw, a read that comes back short of the room has the whole file
+// without one the first read goes straight into the buffer, small files never ask for their size
+// fstat is only asked once a file fills the buffer, from then on short reads are retried until the size it gave
+static bool ReadWholeFile(const char* filepath, u64 size_hint, ReadBuffer* read_buffer, usize* size)
+{
+    // no atime update is one less inode write per file, but it's only allowed on files we own
+    s32 fd = open(filepath, O_RDONLY | O_NOATIME | O_CLOEXEC);
+    if (fd < 0 && errno == EPERM) { fd = open(filepath, O_RDONLY | O_CLOEXEC); }
+    if (fd < 0)
+    {
+        LogDebug("GetFileContents, Failed to open %s (error: %s)\n", filepath, strerror(errno));
+        return false;
+    }
+    
+    usize expected = (usize)(size_hint);
+    usize total = 0;
+    bool asked_size = false;
+    bool ok = ReserveReadBuffer(read_buffer, expected + 1, 0);
+    while (ok)
+    {
+        // the last byte is kept for the nul
+        usize room = read_buffer->memory.size - 1 - total;
+        if (room == 0)
+        {
+            usize wanted = total * 2;
+            struct stat statbuf;
+            if (!asked_size && fstat(fd, &statbuf) == 0 && (usize)(statbuf.st_size) >= total)
+            {
+                expected = (usize)(statbuf.st_size);
+                wanted = expected + 1;
+            }
+            asked_size = true;
+            ok = ReserveReadBuffer(read_buffer, wanted, total);
+            continue;
+        }
+        
+        ssize_t got = read(fd, read_buffer->memory.buffer + total, room);
+        if (got < 0)
+        {
+            if (errno == EINTR) { continue; }
+            LogDebug("GetFileContents, read failed after %zu bytes of %s (error: %s)\n", total, filepath, strerror(errno));
+            ok = false;
+            break;
+        }
+        if (got == 0) { break; }
+        total += (usize)(got);
+        if ((usize)(got) < room && total >= expected) { break; }
+    }
+    
+    close(fd);
+    *size = total;
+    return ok;
+}
+#endif
+
+usize GetFileContentsReusing(FileContents* file_contents, const char* filepath, u64 size_hint, ReadBuffer* read_buffer) 
 {
     if(!file_contents) 
     {
@@ -145,13 +308,19 @@ usize GetFileContents(FileContents* file_contents, const char* filepath)
         return 0;
     }
     
-    usize size = 0;
-    File file = {0};
-    
     file_contents->memory.buffer = 0;
     file_contents->memory.size = 0;
     file_contents->path[0] = '\0';
+    file_contents->borrowed_from = 0;
+    
+    // without a ReadBuffer the memory is made just for this file and FreeFileContents frees it
+    ReadBuffer own_buffer = {0};
+    ReadBuffer* target = read_buffer ? read_buffer : &own_buffer;
+    usize size = 0;
     
+#ifdef OS_Win32
+    (void)(size_hint);
+    File file = {0};
     bool did_open = FileOpen(&file, filepath, "rb");
     if (!did_open || !file.fp)
     {
@@ -163,37 +332,103 @@ usize GetFileContents(FileContents* file_contents, const char* filepath)
     fseek(file.fp, 0, SEEK_END);  
     size = ftell(file.fp);        
     fseek(file.fp, 0, SEEK_SET);  
-
-    if(size == 0) 
+    
+    bool ok = (size > 0) && ReserveReadBuffer(target, size, 0);
+    if (ok)
     {
-        FileClose(&file);
-        LogDebug("GetFileContents, fseek&ftell says file size == 0\n");
-        LogDebug("GetFileContents, filepath: %s\n", filepath);
-        return 0;
+        MemoryBuffer destination = { target->memory.buffer, size + 1 };
+        usize read = FileRead(&destination, size, &file);
+        if(read != size) 
+        {
+            LogDebug("GetFileContents, Failed to read entire file contents\n");
+            LogDebug("GetFileContents, Requested %lld , Got %lld\n", size, read);
+            LogDebug("GetFileContents, filepath: %s\n", filepath);
+            ok = false;
+        }
     }
+    FileClose(&file);
+#else
+    bool ok = ReadWholeFile(filepath, size_hint, target, &size);
+#endif
     
-    Allocate(&file_contents->memory, size + 1);  
-    usize read = FileRead(&file_contents->memory, size, &file);
-    if(read != size) 
+    if(!ok || size == 0) 
     {
-        LogDebug("GetFileContents, Failed to read entire file contents\n");
-        LogDebug("GetFileContents, Requested %lld , Got %lld\n", size, read);
-        LogDebug("GetFileContents, filepath: %s\n", filepath);
-        FileClose(&file);
-        Free(&file_contents->memory);
+        if(ok) { LogDebug("GetFileContents, %s is empty\n", filepath); }
+        if(read_buffer) { ReleaseReadBuffer(read_buffer); }
+        else { FreeReadBuffer(&own_buffer); }
         return 0;
     }
     
+    file_contents->memory.buffer = target->memory.buffer;
     file_contents->memory.buffer[size] = '\0'; 
     file_contents->memory.size = size;
+    file_contents->borrowed_from = read_buffer;
     StringCopy_NullTerminate(file_contents->path, filepath, MaxPath - 1);
-    FileClose(&file);
-    return read;
+    return size;
+}
+
+usize GetStandardInputContents(FileContents* file_contents)
+{
+    if(!file_contents) 
+    {
+        LogDebug("GetStandardInputContents, null file_contents sructure\n");
+        return 0;
+    }
+    
+    file_contents->memory.buffer = 0;
+    file_contents->memory.size = 0;
+    file_contents->borrowed_from = 0;
+    StringCopy_NullTerminate(file_contents->path, "stdin", MaxPath - 1);
+    
+#ifdef OS_Win32
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    
+    // no size to ask for up front, grow as it comes in
+    usize capacity = 64 * 1024;
+    usize size = 0;
+    char* buffer = (char*)(TaggedMalloc(AllocationTag_FileContents, capacity + 1));
+    while (buffer)
+    {
+        usize read = fread(buffer + size, sizeof(char), capacity - size, stdin);
+        size += read;
+        if (read == 0) { break; }
+        if (size == capacity)
+        {
+            char* new_buffer = (char*)(TaggedRealloc(AllocationTag_FileContents, buffer, capacity * 2 + 1));
+            if (!new_buffer) 
+            { 
+                LogDebug("GetStandardInputContents, failed to grow buffer\n");
+                TaggedFree(buffer); 
+                buffer = 0;
+                break; 
+            }
+            buffer = new_buffer;
+            capacity *= 2;
+        }
+    }
+    
+    if (!buffer || size == 0)
+    {
+        TaggedFree(buffer);
+        return 0;
+    }
+    buffer[size] = '\0';
+    file_contents->memory.buffer = buffer;
+    file_contents->memory.size = size;
+    return size;
 }
 
 void FreeFileContents(FileContents* file_contents) 
 {
-    if(file_contents && file_contents->memory.buffer) 
+    if(file_contents && file_contents->borrowed_from)
+    {
+        ReleaseReadBuffer(file_contents->borrowed_from);
+        file_contents->borrowed_from = 0;
+        file_contents->memory.buffer = 0;
+        file_contents->memory.size = 0;
+    }
+    else if(file_contents && file_contents->memory.buffer) 
     {
         Free(&file_contents->memory);
         file_contents->memory.buffer = 0;
@@ -254,9 +489,14 @@ bool DirectoryNextEntry(DirectoryIterator* directory_iterator, DirectoryEntry* e
         snprintf(entry->path, sizeof(entry->path), "%s\\%s", directory_iterator->text_buffer, entry->name);
     }
 
+    entry->device = 0;
+    entry->inode = 0;
+    entry->size = ((u64)(directory_iterator->find_data.nFileSizeHigh) << 32) | directory_iterator->find_data.nFileSizeLow;
+    entry->modified_time = ((u64)(directory_iterator->find_data.ftLastWriteTime.dwHighDateTime) << 32) | directory_iterator->find_data.ftLastWriteTime.dwLowDateTime;
     if (directory_iterator->find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) 
     {
-        entry->type = FileType_Directory;
+        // opening every file for its index is too slow, directories are enough to catch junction loops
+        GetPathInfo(entry->path, entry);
     } 
     else 
     {
@@ -304,26 +544,7 @@ bool DirectoryNextEntry(DirectoryIterator* directory_iterator, DirectoryEntry* e
     
     
     // Determine file type
-    struct stat statbuf;
-    if (stat(entry->path, &statbuf) == 0) 
-    {
-        if (S_ISDIR(statbuf.st_mode)) 
-        {
-            entry->type = FileType_Directory;
-        } 
-        else if (S_ISREG(statbuf.st_mode)) 
-        {
-            entry->type = FileType_File;
-        } 
-        else 
-        {
-            entry->type = FileType_Other;
-        }
-    } 
-    else 
-        {
-        entry->type = FileType_Other;
-    }
+    GetPathInfo(entry->path, entry);
 #endif
 
     return true;
@@ -347,6 +568,121 @@ void DirectoryClose(DirectoryIterator* directory_iterator)
 }
 
 
+static DirectoryListingEntry* DirectoryListing_Add(DirectoryListing* listing, const char* name, usize name_length)
+{
+    if (listing->count >= listing->capacity)
+    {
+        usize new_capacity = listing->capacity ? listing->capacity * 2 : 64;
+        DirectoryListingEntry* new_entries = (DirectoryListingEntry*)(TaggedRealloc(AllocationTag_MessageTable, listing->entries, new_capacity * sizeof(DirectoryListingEntry)));
+        if (!new_entries) { return 0; }
+        listing->entries = new_entries;
+        listing->capacity = new_capacity;
+    }
+    if (listing->names_size + name_length + 1 > listing->names_capacity)
+    {
+        usize new_capacity = listing->names_capacity ? listing->names_capacity * 2 : 4096;
+        while (new_capacity < listing->names_size + name_length + 1) { new_capacity *= 2; }
+        char* new_names = (char*)(TaggedRealloc(AllocationTag_MessageTable, listing->names, new_capacity));
+        if (!new_names) { return 0; }
+        listing->names = new_names;
+        listing->names_capacity = new_capacity;
+    }
+    
+    DirectoryListingEntry* entry = &listing->entries[listing->count++];
+    memset(entry, 0, sizeof(DirectoryListingEntry));
+    entry->type = FileType_Other;
+    entry->name_offset = (u32)(listing->names_size);
+    entry->name_length = (u32)(name_length);
+    memcpy(listing->names + listing->names_size, name, name_length + 1);
+    listing->names_size += name_length + 1;
+    return entry;
+}
+
+bool DirectoryList(DirectoryListing* listing, char* path, usize path_length)
+{
+    listing->count = 0;
+    listing->names_size = 0;
+    
+#ifdef OS_Win32
+    if (path_length + 3 > MaxPath) { return false; }
+    memcpy(path + path_length, "\\*", 3);
+    WIN32_FIND_DATAA find_data;
+    HANDLE handle = FindFirstFileA(path, &find_data);
+    path[path_length] = '\0';
+    if (handle == INVALID_HANDLE_VALUE) { return false; }
+    
+    do
+    {
+        const char* name = find_data.cFileName;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) { continue; }
+        
+        usize name_length = StringLength(name);
+        DirectoryListingEntry* entry = DirectoryListing_Add(listing, name, name_length);
+        if (!entry) { break; }
+        entry->size = ((u64)(find_data.nFileSizeHigh) << 32) | find_data.nFileSizeLow;
+        entry->modified_time = ((u64)(find_data.ftLastWriteTime.dwHighDateTime) << 32) | find_data.ftLastWriteTime.dwLowDateTime;
+        entry->type = FileType_File;
+        entry->link_count = 1;
+        
+        // opening every file for its index is too slow, directories are enough to catch junction loops
+        if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && path_length + name_length + 2 <= MaxPath)
+        {
+            DirectoryEntry info;
+            path[path_length] = '\\';
+            memcpy(path + path_length + 1, name, name_length + 1);
+            GetPathInfo(path, &info);
+            path[path_length] = '\0';
+            entry->type = info.type;
+            entry->device = info.device;
+            entry->inode = info.inode;
+            entry->link_count = info.link_count;
+        }
+    } while (FindNextFileA(handle, &find_data));
+    FindClose(handle);
+#else
+    (void)(path_length);
+    DIR* dir = opendir(path);
+    if (!dir) { return false; }
+    
+    s32 fd = dirfd(dir);
+    struct dirent* dirent;
+    while ((dirent = readdir(dir)))
+    {
+        const char* name = dirent->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) { continue; }
+        
+        DirectoryListingEntry* entry = DirectoryListing_Add(listing, name, StringLength(name));
+        if (!entry) { break; }
+        
+        // follows symlinks like stat, relative to the open directory so the kernel doesn't walk the whole path again
+        struct stat statbuf;
+        if (fstatat(fd, name, &statbuf, 0) != 0) { continue; }
+        if (S_ISDIR(statbuf.st_mode)) { entry->type = FileType_Directory; }
+        else if (S_ISREG(statbuf.st_mode)) { entry->type = FileType_File; }
+        entry->device = (u64)(statbuf.st_dev);
+        entry->inode = (u64)(statbuf.st_ino);
+        entry->modified_time = (u64)(statbuf.st_mtime);
+        entry->size = (u64)(statbuf.st_size);
+        entry->link_count = (u32)(statbuf.st_nlink);
+#ifdef DT_LNK
+        if (dirent->d_type == DT_LNK || dirent->d_type == DT_UNKNOWN) { entry->link_count++; }
+#else
+        entry->link_count++;
+#endif
+    }
+    closedir(dir);
+#endif
+
+    return true;
+}
+
+void DirectoryListing_Free(DirectoryListing* listing)
+{
+    TaggedFree(listing->entries);
+    TaggedFree(listing->names);
+    memset(listing, 0, sizeof(DirectoryListing));
+}
+
 static u32 GetDirectoryPermissions(const char* path) 
 {
     u32 permissions = 0;
@@ -377,6 +713,67 @@ static u32 GetDirectoryPermissions(const char* path)
     return permissions;
 }
 
+FileType GetPathType(const char* path)
+{
+#ifdef OS_Win32
+    DWORD attr = GetFileAttributesA(path);
+    if (attr == INVALID_FILE_ATTRIBUTES) { return FileType_Other; }
+    return (attr & FILE_ATTRIBUTE_DIRECTORY) ? FileType_Directory : FileType_File;
+#else
+    struct stat statbuf;
+    if (stat(path, &statbuf) != 0) { return FileType_Other; }
+    if (S_ISDIR(statbuf.st_mode)) { return FileType_Directory; }
+    if (S_ISREG(statbuf.st_mode)) { return FileType_File; }
+    return FileType_Other;
+#endif
+}
+
+bool GetPathInfo(const char* path, DirectoryEntry* entry)
+{
+    entry->type = FileType_Other;
+    entry->device = 0;
+    entry->inode = 0;
+    entry->modified_time = 0;
+    entry->size = 0;
+    entry->link_count = 1;
+    
+#ifdef OS_Win32
+    DWORD attr = GetFileAttributesA(path);
+    if (attr == INVALID_FILE_ATTRIBUTES) { return false; }
+    entry->type = (attr & FILE_ATTRIBUTE_DIRECTORY) ? FileType_Directory : FileType_File;
+    
+    HANDLE handle = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0);
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+        BY_HANDLE_FILE_INFORMATION info;
+        if (GetFileInformationByHandle(handle, &info))
+        {
+            entry->device = info.dwVolumeSerialNumber;
+            entry->inode = ((u64)(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+            entry->modified_time = ((u64)(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+            entry->size = ((u64)(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+            entry->link_count = (u32)(info.nNumberOfLinks) + ((attr & FILE_ATTRIBUTE_REPARSE_POINT) ? 1 : 0);
+        }
+        CloseHandle(handle);
+    }
+#else
+    // lstat first, only a symlink costs a second call to follow it
+    struct stat statbuf;
+    if (lstat(path, &statbuf) != 0) { return false; }
+    bool is_link = S_ISLNK(statbuf.st_mode);
+    if (is_link && stat(path, &statbuf) != 0) { return false; }
+    if (S_ISDIR(statbuf.st_mode)) { entry->type = FileType_Directory; }
+    else if (S_ISREG(statbuf.st_mode)) { entry->type = FileType_File; }
+    entry->device = (u64)(statbuf.st_dev);
+    entry->inode = (u64)(statbuf.st_ino);
+    entry->modified_time = (u64)(statbuf.st_mtime);
+    entry->size = (u64)(statbuf.st_size);
+    entry->link_count = (u32)(statbuf.st_nlink) + (is_link ? 1 : 0);
+#endif
+
+    return true;
+}
+
 bool GetCurrentDirectoryInfo(DirectoryInfo* directory_info) 
 {
     if (directory_info == 0) { return false; }
@@ -0,0 +1,452 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// streaming deflate decoder (rfc 1951) behind a gzip container (rfc 1952)
+//
+// input is pulled from the file as the decoder needs it, so decoding a symbol never has to stop half way
+// output goes into the 32k history window and GzipRead copies it out from there
+// we only decode while the window holds less than InflateChunk unread bytes, that plus the longest match
+// (258) stays under the window size so nothing unread or still referenced gets overwritten
+
+#define InflateWindowSize 32768
+#define InflateWindowMask (InflateWindowSize - 1)
+#define InflateChunk 16384
+
+//=====================================================================================================================
+// Bits
+//=====================================================================================================================
+static bool RefillInput(GzipReader* reader)
+{
+    reader->input_size = FileRead(&(MemoryBuffer){ (char*)(reader->input), sizeof(reader->input) }, sizeof(reader->input), &reader->file);
+    reader->input_position = 0;
+    return reader->input_size > 0;
+}
+
+// makes sure at least count bits are buffered, pads with zeros past the end of the file
+static void NeedBits(GzipReader* reader, u32 count)
+{
+    while (reader->bit_count < count)
+    {
+        u64 byte = 0;
+        if (reader->input_position < reader->input_size || RefillInput(reader))
+        {
+            byte = reader->input[reader->input_position++];
+        }
+        else
+        {
+            reader->padding_bits += 8;
+        }
+        reader->bit_buffer |= byte << reader->bit_count;
+        reader->bit_count += 8;
+    }
+}
+
+static u32 GetBits(GzipReader* reader, u32 count)
+{
+    if (count == 0) { return 0; }
+    NeedBits(reader, count);
+    u32 bits = (u32)(reader->bit_buffer & ((1ull << count) - 1));
+    reader->bit_buffer >>= count;
+    reader->bit_count -= count;
+    // reading into the zero padding means the stream was cut short
+    if (reader->padding_bits > reader->bit_count) { reader->error = true; }
+    return bits;
+}
+
+static u8 GetByte(GzipReader* reader)
+{
+    if (reader->input_position < reader->input_size || RefillInput(reader))
+    {
+        return reader->input[reader->input_position++];
+    }
+    reader->error = true;
+    return 0;
+}
+
+//=====================================================================================================================
+// Huffman
+//=====================================================================================================================
+// canonical codes, counts/symbols for the bit at a time slow path
+// fast is indexed by the next InflateFastBits of input and holds (symbol << 4) | length, 0 when the code is longer
+static bool BuildHuffman(InflateHuffman* huffman, const u8* lengths, u32 count)
+{
+    memset(huffman->counts, 0, sizeof(huffman->counts));
+    memset(huffman->fast, 0, sizeof(huffman->fast));
+    for (u32 i = 0; i < count; i++) { huffman->counts[lengths[i]]++; }
+    huffman->counts[0] = 0;
+    
+    // over subscribed sets are broken, incomplete ones are allowed (single distance codes)
+    s32 left = 1;
+    for (u32 length = 1; length < 16; length++)
+    {
+        left <<= 1;
+        left -= huffman->counts[length];
+        if (left < 0) { return false; }
+    }
+    
+    u16 offsets[16];
+    offsets[1] = 0;
+    for (u32 length = 1; length < 15; length++) { offsets[length + 1] = offsets[length] + huffman->counts[length]; }
+    for (u32 i = 0; i < count; i++)
+    {
+        if (lengths[i]) { huffman->symbols[offsets[lengths[i]]++] = (u16)(i); }
+    }
+    
+    // walk the codes in canonical order and fill the fast table for the short ones
+    u32 code = 0;
+    u32 index = 0;
+    for (u32 length = 1; length <= InflateFastBits; length++)
+    {
+        for (u32 i = 0; i < huffman->counts[length]; i++, code++, index++)
+        {
+            // deflate stores codes starting at the top bit, our bit buffer hands them out lowest bit first
+            u32 reversed = 0;
+            for (u32 b = 0; b < length; b++) { reversed |= ((code >> b) & 1) << (length - 1 - b); }
+            for (u32 fill = reversed; fill < (1u << InflateFastBits); fill += (1u << length))
+            {
+                huffman->fast[fill] = (u16)((huffman->symbols[index] << 4) | length);
+            }
+        }
+        code <<= 1;
+    }
+    return true;
+}
+
+static s32 DecodeSymbol(GzipReader* reader, InflateHuffman* huffman)
+{
+    NeedBits(reader, InflateFastBits);
+    u16 entry = huffman->fast[reader->bit_buffer & ((1u << InflateFastBits) - 1)];
+    if (entry)
+    {
+        GetBits(reader, entry & 15);
+        return entry >> 4;
+    }
+    
+    // long code, one bit at a time
+    s32 code = 0;
+    s32 first = 0;
+    s32 index = 0;
+    for (u32 length = 1; length < 16; length++)
+    {
+        code |= (s32)(GetBits(reader, 1));
+        s32 count = huffman->counts[length];
+        if (code - count < first) { return huffman->symbols[index + (code - first)]; }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    reader->error = true;
+    return -1;
+}
+
+//=====================================================================================================================
+// Blocks
+//=====================================================================================================================
+static const u16 length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const u8 length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const u16 distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const u8 distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// crc32 of each member's output, checked against its trailer
+static const u32 crc_table[256] =
+{
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
+    0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
+    0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
+    0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172, 0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
+    0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
+    0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924, 0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
+    0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
+    0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E, 0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
+    0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
+    0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0, 0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
+    0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
+    0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A, 0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
+    0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
+    0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC, 0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
+    0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
+    0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236, 0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
+    0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
+    0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38, 0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
+    0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
+    0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2, 0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
+    0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
+    0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D,
+};
+
+static inline void PutByte(GzipReader* reader, u8 byte)
+{
+    reader->window[reader->write_total & InflateWindowMask] = byte;
+    reader->write_total++;
+    reader->crc = crc_table[(reader->crc ^ byte) & 0xFF] ^ (reader->crc >> 8);
+}
+
+static bool BuildFixedTables(GzipReader* reader)
+{
+    u8 lengths[288 + 30];
+    u32 i = 0;
+    for (; i < 144; i++) { lengths[i] = 8; }
+    for (; i < 256; i++) { lengths[i] = 9; }
+    for (; i < 280; i++) { lengths[i] = 7; }
+    for (; i < 288; i++) { lengths[i] = 8; }
+    for (; i < 288 + 30; i++) { lengths[i] = 5; }
+    return BuildHuffman(&reader->literals, lengths, 288) && BuildHuffman(&reader->distances, lengths + 288, 30);
+}
+
+static bool BuildDynamicTables(GzipReader* reader)
+{
+    static const u8 order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    u32 literal_count = GetBits(reader, 5) + 257;
+    u32 distance_count = GetBits(reader, 5) + 1;
+    u32 code_count = GetBits(reader, 4) + 4;
+    if (literal_count > 286 || distance_count > 30) { return false; }
+    
+    u8 lengths[288 + 32] = {0};
+    for (u32 i = 0; i < code_count; i++) { lengths[order[i]] = (u8)(GetBits(reader, 3)); }
+    
+    InflateHuffman* code_lengths = &reader->distances; // borrowed until the real distance table is built
+    if (!BuildHuffman(code_lengths, lengths, 19)) { return false; }
+    
+    u32 total = literal_count + distance_count;
+    u32 index = 0;
+    memset(lengths, 0, sizeof(lengths));
+    while (index < total && !reader->error)
+    {
+        s32 symbol = DecodeSymbol(reader, code_lengths);
+        if (symbol < 0) { return false; }
+        if (symbol < 16) { lengths[index++] = (u8)(symbol); continue; }
+        
+        u8 repeat_length = 0;
+        u32 repeat = 0;
+        if (symbol == 16)
+        {
+            if (index == 0) { return false; }
+            repeat_length = lengths[index - 1];
+            repeat = 3 + GetBits(reader, 2);
+        }
+        else if (symbol == 17) { repeat = 3 + GetBits(reader, 3); }
+        else { repeat = 11 + GetBits(reader, 7); }
+        
+        if (index + repeat > total) { return false; }
+        while (repeat--) { lengths[index++] = repeat_length; }
+    }
+    if (reader->error || lengths[256] == 0) { return false; }
+    
+    return BuildHuffman(&reader->literals, lengths, literal_count) && BuildHuffman(&reader->distances, lengths + literal_count, distance_count);
+}
+
+// gzip member header, returns false if this isn't gzip
+static bool ReadGzipHeader(GzipReader* reader)
+{
+    u8 id1 = GetByte(reader);
+    u8 id2 = GetByte(reader);
+    u8 method = GetByte(reader);
+    u8 flags = GetByte(reader);
+    if (reader->error || id1 != 0x1f || id2 != 0x8b || method != 8) { return false; }
+    
+    for (u32 i = 0; i < 6; i++) { GetByte(reader); } // mtime, extra flags, os
+    if (flags & 0x04) 
+    { 
+        u32 extra_length = GetByte(reader);
+        extra_length |= (u32)(GetByte(reader)) << 8;
+        while (extra_length-- && !reader->error) { GetByte(reader); }
+    }
+    if (flags & 0x08) { while (GetByte(reader) && !reader->error) {} } // file name
+    if (flags & 0x10) { while (GetByte(reader) && !reader->error) {} } // comment
+    if (flags & 0x02) { GetByte(reader); GetByte(reader); }             // header crc
+    return !reader->error;
+}
+
+// decodes until there is something to read, the stream ends or it breaks
+static void InflateSome(GzipReader* reader)
+{
+    while (!reader->error && !reader->finished && reader->write_total - reader->read_total < InflateChunk)
+    {
+        switch (reader->state)
+        {
+            case InflateState_BlockHeader:
+            {
+                reader->last_block = GetBits(reader, 1) != 0;
+                u32 type = GetBits(reader, 2);
+                if (type == 0)
+                {
+                    // stored, byte aligned length and its complement
+                    GetBits(reader, reader->bit_count & 7);
+                    u32 length = GetBits(reader, 16);
+                    u32 complement = GetBits(reader, 16);
+                    if ((length ^ 0xFFFF) != complement) { reader->error = true; break; }
+                    reader->stored_remaining = length;
+                    reader->state = InflateState_Stored;
+                }
+                else if (type == 1)
+                {
+                    if (!BuildFixedTables(reader)) { reader->error = true; break; }
+                    reader->state = InflateState_Huffman;
+                }
+                else if (type == 2)
+                {
+                    if (!BuildDynamicTables(reader)) { reader->error = true; break; }
+                    reader->state = InflateState_Huffman;
+                }
+                else
+                {
+                    reader->error = true;
+                }
+            } break;
+            
+            case InflateState_Stored:
+            {
+                if (reader->stored_remaining == 0) { reader->state = InflateState_BlockEnd; break; }
+                // whole bytes may still be sitting in the bit buffer
+                u8 byte = (reader->bit_count >= 8) ? (u8)(GetBits(reader, 8)) : GetByte(reader);
+                PutByte(reader, byte);
+                reader->stored_remaining--;
+            } break;
+            
+            case InflateState_Huffman:
+            {
+                s32 symbol = DecodeSymbol(reader, &reader->literals);
+                if (symbol < 0) { break; }
+                if (symbol < 256) { PutByte(reader, (u8)(symbol)); break; }
+                if (symbol == 256) { reader->state = InflateState_BlockEnd; break; }
+                
+                symbol -= 257;
+                if (symbol >= 29) { reader->error = true; break; }
+                u32 length = length_base[symbol] + GetBits(reader, length_extra[symbol]);
+                
+                s32 distance_symbol = DecodeSymbol(reader, &reader->distances);
+                if (distance_symbol < 0 || distance_symbol >= 30) { reader->error = true; break; }
+                u32 distance = distance_base[distance_symbol] + GetBits(reader, distance_extra[distance_symbol]);
+                if (distance > reader->write_total - reader->member_start) { reader->error = true; break; }
+                
+                while (length--)
+                {
+                    PutByte(reader, reader->window[(reader->write_total - distance) & InflateWindowMask]);
+                }
+            } break;
+            
+            case InflateState_BlockEnd:
+            {
+                if (!reader->last_block) { reader->state = InflateState_BlockHeader; break; }
+                
+                // crc32 and size trailer, then maybe another member glued on the end
+                GetBits(reader, reader->bit_count & 7);
+                u64 trailer = 0;
+                for (u32 i = 0; i < 8; i++) 
+                { 
+                    u64 byte = (reader->bit_count >= 8) ? GetBits(reader, 8) : GetByte(reader);
+                    trailer |= byte << (i * 8);
+                }
+                if (reader->error) { break; }
+                if ((u32)(trailer) != ~reader->crc || (u32)(trailer >> 32) != (u32)(reader->write_total - reader->member_start)) 
+                { 
+                    reader->error = true; 
+                    break; 
+                }
+                reader->bit_buffer = 0;
+                reader->bit_count = 0;
+                reader->padding_bits = 0;
+                
+                if (reader->input_position >= reader->input_size && !RefillInput(reader))
+                {
+                    reader->finished = true;
+                    break;
+                }
+                if (!ReadGzipHeader(reader)) 
+                { 
+                    // trailing garbage after a complete member is common, stop there
+                    reader->error = false;
+                    reader->finished = true;
+                    break;
+                }
+                reader->member_start = reader->write_total;
+                reader->crc = 0xFFFFFFFF;
+                reader->state = InflateState_BlockHeader;
+            } break;
+        }
+    }
+}
+
+//=====================================================================================================================
+// Public
+//=====================================================================================================================
+bool GzipOpen(GzipReader* reader, const char* path)
+{
+    memset(reader, 0, sizeof(GzipReader));
+    if (!FileOpen(&reader->file, path, "rb")) { return false; }
+    if (!ReadGzipHeader(reader))
+    {
+        LogDebug("GzipOpen, not a gzip file: %s\n", path);
+        FileClose(&reader->file);
+        return false;
+    }
+    reader->crc = 0xFFFFFFFF;
+    reader->state = InflateState_BlockHeader;
+    return true;
+}
+
+usize GzipRead(GzipReader* reader, u8* destination, usize count)
+{
+    usize copied = 0;
+    while (copied < count)
+    {
+        if (reader->write_total == reader->read_total)
+        {
+            if (reader->finished || reader->error) { break; }
+            InflateSome(reader);
+            continue;
+        }
+        
+        // copy out the unread part of the window, it may wrap around
+        u64 available = reader->write_total - reader->read_total;
+        usize offset = (usize)(reader->read_total & InflateWindowMask);
+        usize run = InflateWindowSize - offset;
+        if (run > available) { run = (usize)(available); }
+        if (run > count - copied) { run = count - copied; }
+        
+        memcpy(destination + copied, reader->window + offset, run);
+        copied += run;
+        reader->read_total += run;
+    }
+    return copied;
+}
+
+void GzipClose(GzipReader* reader)
+{
+    FileClose(&reader->file);
+}
@@ -25,27 +25,250 @@
 
 #include "common.h"
 
-static File log_file;   
-void CloseLogFile() { FileClose(&log_file); }
+#ifdef NDEBUG
+s32 log_level = LogLevel_Info;
+#else
+s32 log_level = LogLevel_Debug;
+#endif
 
-void LogMessage(const char* format, ...)        
+bool ParseLogLevel(const char* name, s32* level)
+{
+    if(StringCompare(name, "info") == 0)  { *level = LogLevel_Info;  return true; }
+    if(StringCompare(name, "debug") == 0) { *level = LogLevel_Debug; return true; }
+    return false;
+}
+
+// library hosts get the messages instead of the log file and stdout
+// the library build is silent until a host asks for them
+static TodoFinderLogCallback log_callback;
+static void* log_callback_user_data;
+
+void TodoFinder_SetLogCallback(TodoFinderLogCallback log, void* user_data)
+{
+    log_callback = log;
+    log_callback_user_data = user_data;
+}
+
+#ifndef TODO_FINDER_LIBRARY
+// one per thread that has logged, single producer single consumer
+// the owning thread only moves write and only after a whole message is in, so the writer never splits a message
+// the writer only moves read, both wrap around as u32 and are masked into data
+// rings are drained in the order threads first logged, so what the main thread logged before starting workers comes out first
+// messages from different threads are only ordered by which drain picked them up
+// a thread that exits hands its ring back and the next new thread takes it over, whatever it left unwritten still goes first
+// so there are only ever as many rings as threads logging at the same time
+#define LogRingSize (64 * 1024)
+typedef struct LogRing
+{
+    struct LogRing* volatile next;
+    volatile u32 owned; // 1 while a thread is writing to it
+    volatile u32 write;
+    volatile u32 read;
+    char data[LogRingSize];
+} LogRing;
+
+typedef enum LogWriterState
+{
+    LogWriter_NotStarted,
+    LogWriter_Running,
+    LogWriter_Stopping,
+    LogWriter_Direct, // no writer thread, either it couldn't start or it has been stopped at exit
+} LogWriterState;
+
+static File log_file;
+static Thread log_writer;
+static volatile u32 log_writer_state;
+static LogRing* volatile log_rings; // appended to the end, reused once their thread exits, only freed at exit
+static ThreadLocal LogRing* thread_log_ring;
+
+static void WriteLogText(const char* text, usize size)
+{
+    if(log_file.fp) { fwrite(text, 1, size, log_file.fp); }
+    fwrite(text, 1, size, stdout);
+}
+
+// returns false when there was nothing to write
+static bool DrainLogRings()
+{
+    bool wrote = false;
+    for(LogRing* ring = (LogRing*)(AtomicLoadAcquirePointer((void* volatile*)(&log_rings))); ring; ring = (LogRing*)(AtomicLoadAcquirePointer((void* volatile*)(&ring->next))))
+    {
+        u32 write = AtomicLoadAcquire(&ring->write);
+        u32 read = ring->read;
+        if(write == read) { continue; }
+        
+        u32 start = read & (LogRingSize - 1);
+        u32 size = write - read;
+        u32 first = (size < LogRingSize - start) ? size : LogRingSize - start;
+        WriteLogText(ring->data + start, first);
+        if(size > first) { WriteLogText(ring->data, size - first); }
+        AtomicStoreRelease(&ring->read, write);
+        wrote = true;
+    }
+    
+    if(wrote)
+    {
+        fflush(stdout);
+        if(log_file.fp) { fflush(log_file.fp); }
+    }
+    return wrote;
+}
+
+static void LogWriterMain(void* data)
+{
+    (void)(data);
+    while(AtomicLoadAcquire(&log_writer_state) == LogWriter_Running)
+    {
+        if(!DrainLogRings()) { Thread_Sleep(1); }
+    }
+    DrainLogRings();
+}
+
+// stops the writer after it has written everything, anything logged later is written directly
+void CloseLogFile() 
+{ 
+    if(AtomicLoadAcquire(&log_writer_state) == LogWriter_Running)
+    {
+        AtomicStoreRelease(&log_writer_state, LogWriter_Stopping);
+        Thread_Join(&log_writer);
+        AtomicStoreRelease(&log_writer_state, LogWriter_Direct);
+    }
+    DrainLogRings();
+    FileClose(&log_file); 
+    log_file.fp = 0;
+    
+    LogRing* ring = log_rings;
+    log_rings = 0;
+    thread_log_ring = 0;
+    while(ring)
+    {
+        LogRing* next = ring->next;
+        free(ring);
+        ring = next;
+    }
+}
+
+// only the first thread to log gets here, AtExit logs through LogMessage too so the state is set first
+static void StartLogWriter()
+{
+    FileOpen(&log_file, log_file_name, "w+");
+    AtExit(CloseLogFile);
+    if(!Thread_Start(&log_writer, LogWriterMain, 0)) 
+    { 
+        AtomicStoreRelease(&log_writer_state, LogWriter_Direct); 
+    }
+}
+
+static LogRing* GetThreadLogRing()
 {
-    // try to open log file if its closed
-    if(!log_file.fp)
+    if(thread_log_ring) { return thread_log_ring; }
+    
+    // the owner only ever moves write, taking over a released ring carries on from where the last one stopped
+    for(LogRing* ring = (LogRing*)(AtomicLoadAcquirePointer((void* volatile*)(&log_rings))); ring; ring = (LogRing*)(AtomicLoadAcquirePointer((void* volatile*)(&ring->next))))
+    {
+        if(AtomicLoadAcquire(&ring->owned) == 0 && AtomicCompareExchange(&ring->owned, 0, 1))
+        {
+            thread_log_ring = ring;
+            return ring;
+        }
+    }
+    
+    LogRing* ring = (LogRing*)(malloc(sizeof(LogRing)));
+    if(!ring) { return 0; }
+    ring->next = 0;
+    ring->owned = 1;
+    ring->write = 0;
+    ring->read = 0;
+    
+    // the list only grows, so walking to the end and swapping in the null next pointer can't lose a ring
+    LogRing* volatile* link = &log_rings;
+    while(!AtomicCompareExchangePointer((void* volatile*)(link), 0, ring))
     {
-        FileOpen(&log_file, log_file_name, "w+");
-        AtExit(CloseLogFile);
+        LogRing* last = (LogRing*)(AtomicLoadAcquirePointer((void* volatile*)(link)));
+        link = &last->next;
     }
     
-    // log to file if open and stdout                                  
-    va_list arg_ptr;  
-    if (log_file.fp)
+    thread_log_ring = ring;
+    return ring;
+}
+
+void ReleaseThreadLogRing()
+{
+    if(!thread_log_ring) { return; }
+    AtomicStoreRelease(&thread_log_ring->owned, 0);
+    thread_log_ring = 0;
+}
+
+// a message bigger than the ring goes in as it fits, the only case where the writer can split one
+static void PushLogText(LogRing* ring, const char* text, usize size)
+{
+    while(size > 0)
     {
-        va_start(arg_ptr, format); 
-        vfprintf(log_file.fp, format, arg_ptr);  
-        va_end(arg_ptr); 
-    }                                            
+        u32 write = ring->write;
+        u32 room = LogRingSize - (write - AtomicLoadAcquire(&ring->read));
+        if(room < size && (room == 0 || size <= LogRingSize))
+        {
+            // full, wait for the writer unless it has gone away
+            if(AtomicLoadAcquire(&log_writer_state) != LogWriter_Running) 
+            { 
+                WriteLogText(text, size); 
+                return; 
+            }
+            Thread_Sleep(0);
+            continue;
+        }
+        
+        u32 count = (size < room) ? (u32)(size) : room;
+        u32 start = write & (LogRingSize - 1);
+        u32 first = (count < LogRingSize - start) ? count : LogRingSize - start;
+        memcpy(ring->data + start, text, first);
+        memcpy(ring->data, text + first, count - first);
+        AtomicStoreRelease(&ring->write, write + count);
+        text += count;
+        size -= count;
+    }
+}
+#else
+void ReleaseThreadLogRing() {}
+#endif
+
+void LogMessage(const char* format, ...)        
+{
+    // formatted on the calling thread, only finished text goes through the rings
+    char message[2048];
+    char* text = message;
+    va_list arg_ptr;
     va_start(arg_ptr, format);
-    vprintf(format, arg_ptr);
+    s32 length = vsnprintf(message, sizeof(message), format, arg_ptr);
     va_end(arg_ptr);
+    if(length < 0) { return; }
+    if((usize)(length) >= sizeof(message))
+    {
+        text = (char*)(malloc((usize)(length) + 1));
+        if(!text) { return; }
+        va_start(arg_ptr, format);
+        vsnprintf(text, (usize)(length) + 1, format, arg_ptr);
+        va_end(arg_ptr);
+    }
+    
+    if(log_callback)
+    {
+        log_callback(text, log_callback_user_data);
+    }
+#ifndef TODO_FINDER_LIBRARY
+    else
+    {
+        if(AtomicLoadAcquire(&log_writer_state) == LogWriter_NotStarted && 
+           AtomicCompareExchange(&log_writer_state, LogWriter_NotStarted, LogWriter_Running)) 
+        { 
+            StartLogWriter(); 
+        }
+        
+        LogRing* ring = (AtomicLoadAcquire(&log_writer_state) == LogWriter_Running) ? GetThreadLogRing() : 0;
+        if(ring) { PushLogText(ring, text, (usize)(length)); }
+        else     { WriteLogText(text, (usize)(length)); }
+    }
+#endif
+    
+    if(text != message) { free(text); }
 }
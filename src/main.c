@@ -50,6 +50,10 @@ s32 main(s32 argc, char** argv)
     //     this means the size of the table is dependent on user config
     //     there is a default table of symbol keyword pairs if none is provided
     // it also holds string vectors regarding user config, like ignored directories, extensions, etc
+    if(!IsUserConfigUsable(user_config))
+    {
+        Exit(-1);
+    }
     MessageTable* message_table = AllocateMessageTable(user_config);
     if(!message_table) 
     { 
@@ -59,20 +63,67 @@ s32 main(s32 argc, char** argv)
     
     // build the message table by parsing the files/folders requested
     // this fills up the message buckets with found matches of [symbol][keyword]
-    ProcessUserRequest(message_table, argc, argv);
+    if(!ParseUserArguments(&message_table->arguments, argc, argv))
+    {
+        PrintUsage();
+        Exit(-1);
+    }
+    if(message_table->arguments.log_level) { ParseLogLevel(message_table->arguments.log_level, &log_level); }
+    if(!ProcessUserRequest(message_table))
+    {
+        Exit(-1);
+    }
     
     // show the user the results
-    PrintSearchPatterns(message_table);
-    PrintIgnoredDirectories(message_table);
-    PrintIgnoredFiles(message_table);
-    PrintEmptyFiles(message_table);
-    PrintMessages(message_table);
+    // a shard writing partial results leaves the report to --merge
+    // a baseline diff only shows what changed
+    if(message_table->arguments.diff_baseline)
+    {
+        if(!PrintBaselineDiff(message_table, message_table->arguments.diff_baseline))
+        {
+            Exit(-1);
+        }
+    }
+    else if(message_table->arguments.emit_partial)
+    {
+        if(!WritePartialResults(message_table, message_table->arguments.emit_partial))
+        {
+            Exit(-1);
+        }
+        Log("Wrote %zu matches to %s\n", message_table->match_count, message_table->arguments.emit_partial);
+    }
+    else
+    {
+        PrintSearchPatterns(message_table);
+        PrintIgnoredDirectories(message_table);
+        PrintIgnoredFiles(message_table);
+        PrintEmptyFiles(message_table);
+        PrintMessages(message_table);
+        PrintRollup(message_table);
+    }
+    
+    // saved after the diff so a baseline can be diffed and rolled forward in one run
+    if(message_table->arguments.save_baseline)
+    {
+        if(!SaveBaseline(message_table, message_table->arguments.save_baseline))
+        {
+            Exit(-1);
+        }
+        Log("Saved %zu matches to the baseline %s\n", message_table->baseline.count, message_table->arguments.save_baseline);
+    }
     
+    // before the table is freed so what it still holds shows up as live
+    if(message_table->arguments.mem_stats)
+    {
+        PrintAllocationStats();
+    }
 
     Log("=======================================================================================================================\n\n");
 
     // clean up and call global destructors
+    // exit code is non zero when a --fail-on keyword was found
+    s32 exit_code = message_table->exit_code;
     FreeMessageTable(message_table);
-    Exit(0);
+    Exit(exit_code);
     
 }
\ No newline at end of file
@@ -25,9 +25,129 @@
 
 #include "common.h"
 
+#ifdef TRACK_ALLOCATIONS
+// 16 bytes so the memory handed out keeps malloc's alignment
+typedef struct AllocationHeader
+{
+    u64 size;
+    u32 tag;
+    u32 check;
+} AllocationHeader;
+#define AllocationCheck 0x7A11C8EDu
+
+// updated from every thread, peak is the most that was live at once
+typedef struct AllocationStats
+{
+    volatile u64 allocations;
+    volatile u64 frees;
+    volatile u64 reallocations;
+    volatile u64 bytes_moved;     // what a growing realloc had to copy, the churn of doubling vectors
+    volatile u64 bytes_allocated;
+    volatile u64 live_bytes;
+    volatile u64 peak_live_bytes;
+} AllocationStats;
+
+static AllocationStats allocation_stats[AllocationTag_Count];
+static volatile u64 total_live_bytes;
+static volatile u64 total_peak_live_bytes;
+
+static void AddLiveBytes(AllocationStats* stats, u64 size)
+{
+    AtomicMax64(&stats->peak_live_bytes, AtomicAdd64(&stats->live_bytes, size));
+    AtomicMax64(&total_peak_live_bytes, AtomicAdd64(&total_live_bytes, size));
+}
+
+static void RemoveLiveBytes(AllocationStats* stats, u64 size)
+{
+    AtomicAdd64(&stats->live_bytes, (u64)(0) - size);
+    AtomicAdd64(&total_live_bytes, (u64)(0) - size);
+}
+
+void* TrackedMalloc(AllocationTag tag, usize size)
+{
+    AllocationHeader* header = (AllocationHeader*)(malloc(sizeof(AllocationHeader) + size));
+    if (!header) { return 0; }
+    header->size = size;
+    header->tag = (u32)(tag);
+    header->check = AllocationCheck;
+    
+    AllocationStats* stats = &allocation_stats[tag];
+    AtomicAdd64(&stats->allocations, 1);
+    AtomicAdd64(&stats->bytes_allocated, size);
+    AddLiveBytes(stats, size);
+    return header + 1;
+}
+
+void* TrackedCalloc(AllocationTag tag, usize count, usize size)
+{
+    if (size && count > (usize)(-1) / size) { return 0; }
+    void* memory = TrackedMalloc(tag, count * size);
+    if (memory) { memset(memory, 0, count * size); }
+    return memory;
+}
+
+void* TrackedRealloc(AllocationTag tag, void* memory, usize size)
+{
+    if (!memory) { return TrackedMalloc(tag, size); }
+    
+    AllocationHeader* header = (AllocationHeader*)(memory) - 1;
+    assert(header->check == AllocationCheck && "TrackedRealloc given memory that wasn't tracked");
+    u64 old_size = header->size;
+    AllocationHeader* new_header = (AllocationHeader*)(realloc(header, sizeof(AllocationHeader) + size));
+    if (!new_header) { return 0; }
+    new_header->size = size;
+    
+    // the block keeps the tag it was made with
+    AllocationStats* stats = &allocation_stats[new_header->tag];
+    AtomicAdd64(&stats->reallocations, 1);
+    AtomicAdd64(&stats->bytes_moved, (old_size < size) ? old_size : size);
+    if (size > old_size)
+    {
+        AtomicAdd64(&stats->bytes_allocated, size - old_size);
+        AddLiveBytes(stats, size - old_size);
+    }
+    else { RemoveLiveBytes(stats, old_size - size); }
+    return new_header + 1;
+}
+
+void TrackedFree(void* memory)
+{
+    if (!memory) { return; }
+    
+    AllocationHeader* header = (AllocationHeader*)(memory) - 1;
+    assert(header->check == AllocationCheck && "TrackedFree given memory that wasn't tracked");
+    AllocationStats* stats = &allocation_stats[header->tag];
+    AtomicAdd64(&stats->frees, 1);
+    RemoveLiveBytes(stats, header->size);
+    header->check = 0;
+    free(header);
+}
+
+void PrintAllocationStats()
+{
+    static const char* tag_names[AllocationTag_Count] = { "file contents", "string vectors", "message table" };
+    
+    Log("Memory:\n");
+    Log("    %-16s %12s %12s %12s %14s %14s %14s\n", "", "allocations", "frees", "reallocs", "realloc moved", "total bytes", "peak live");
+    for (usize i = 0; i < AllocationTag_Count; i++)
+    {
+        AllocationStats* stats = &allocation_stats[i];
+        Log("    %-16s %12llu %12llu %12llu %14llu %14llu %14llu\n", tag_names[i], 
+            (unsigned long long)(stats->allocations), (unsigned long long)(stats->frees), (unsigned long long)(stats->reallocations),
+            (unsigned long long)(stats->bytes_moved), (unsigned long long)(stats->bytes_allocated), (unsigned long long)(stats->peak_live_bytes));
+    }
+    Log("    peak live across all tags %llu bytes, the peaks above can happen at different times\n\n", (unsigned long long)(total_peak_live_bytes));
+}
+#else
+void PrintAllocationStats()
+{
+    Log("Memory:\n    --mem-stats needs a build with -DTRACK_ALLOCATIONS, debug builds have it\n\n");
+}
+#endif
+
 void Allocate(MemoryBuffer* memory, usize bytes) 
 {
-    memory->buffer = (char*)(malloc(bytes));
+    memory->buffer = (char*)(TaggedMalloc(AllocationTag_FileContents, bytes));
     assert(memory->buffer && "Malloc Failed to allocate MemoryBuffer");
     memory->size = bytes;    
 }
@@ -35,6 +155,6 @@ void Allocate(MemoryBuffer* memory, usize bytes)
 void Free(MemoryBuffer* memory) 
 {
     assert(memory && memory->buffer && "Free called on null MemoryBuffer");
-    free(memory->buffer);
+    TaggedFree(memory->buffer);
     memory->size = 0;
 }
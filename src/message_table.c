@@ -25,6 +25,11 @@
 
 #include "common.h"
 
+// generated into the build directory by tools/generate_matcher.c, see build_compiler_gcc.sh
+#ifdef TODO_BAKED_MATCHER
+    #include "baked_matcher.h"
+#endif
+
 static const char* default_symbols[] = 
 {
     "@"
@@ -47,12 +52,253 @@ static const char* default_ignore_extensions[] =
 
 
 
+static void AddSymbolFirstByte(MessageTable* message_table, u8 byte)
+{
+    for (usize i = 0; i < message_table->symbol_first_byte_count; i++)
+    {
+        if (message_table->symbol_first_bytes[i] == byte) { return; }
+    }
+    message_table->symbol_first_bytes[message_table->symbol_first_byte_count++] = byte;
+}
+
+// flattens symbols x keywords into one list of literal patterns so ProcessLine never formats anything
+static bool BuildSearchPatterns(MessageTable* message_table)
+{
+    usize pattern_count = message_table->symbols.size * message_table->keywords.size;
+    message_table->patterns = (SearchPattern*)(TaggedCalloc(AllocationTag_MessageTable, pattern_count, sizeof(SearchPattern)));
+    if (!message_table->patterns) { return false; }
+    
+    usize text_size = 0;
+    for (usize s = 0; s < message_table->symbols.size; s++)
+    {
+        usize symbol_length = StringLength(message_table->symbols.data[s]);
+        for (usize k = 0; k < message_table->keywords.size; k++) { text_size += symbol_length + StringLength(message_table->keywords.data[k]) + 1; }
+    }
+    message_table->pattern_text = (char*)(TaggedMalloc(AllocationTag_MessageTable, text_size + 1));
+    if (!message_table->pattern_text) { return false; }
+    char* text = message_table->pattern_text;
+    
+    for (usize s = 0; s < message_table->symbols.size; s++)
+    {
+        usize symbol_length = StringLength(message_table->symbols.data[s]);
+        for (usize k = 0; k < message_table->keywords.size; k++) 
+        {
+            SearchPattern* pattern = &message_table->patterns[message_table->pattern_count];
+            bool case_insensitive = message_table->keyword_case_insensitive && message_table->keyword_case_insensitive[k];
+            
+            usize keyword_length = StringLength(message_table->keywords.data[k]);
+            memcpy(text, message_table->symbols.data[s], symbol_length);
+            memcpy(text + symbol_length, message_table->keywords.data[k], keyword_length);
+            text[symbol_length + keyword_length] = '\0';
+            pattern->text = text;
+            pattern->length = symbol_length + keyword_length;
+            text += pattern->length + 1;
+            pattern->symbol = (s32)s;
+            pattern->keyword = (s32)k;
+            pattern->case_insensitive = case_insensitive;
+            if (pattern->length == 0) { continue; }
+            
+            if (case_insensitive)
+            {
+                for (usize i = 0; i < pattern->length; i++) { pattern->text[i] = FoldCase(pattern->text[i]); }
+                AddSymbolFirstByte(message_table, (u8)(pattern->text[0]));
+                if (isalpha((u8)(pattern->text[0]))) { AddSymbolFirstByte(message_table, (u8)(toupper((u8)(pattern->text[0])))); }
+            }
+            else
+            {
+                AddSymbolFirstByte(message_table, (u8)(pattern->text[0]));
+            }
+            message_table->pattern_count++;
+        }
+    }
+    return message_table->pattern_count > 0;
+}
+
+// past this many patterns the pattern loop in ProcessLine costs more than walking the trie
+#define LargeVocabularyPatterns 256
+
+static u64 HashTrieEdge(u32 from, u8 byte)
+{
+    u64 hash = ((u64)(from) << 8 | byte) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 29);
+}
+
+static u32 FindTrieEdge(PatternTrie* trie, u32 from, u8 byte)
+{
+    usize mask = trie->edge_capacity - 1;
+    usize slot = HashTrieEdge(from, byte) & mask;
+    while (trie->edges[slot].to)
+    {
+        if (trie->edges[slot].from == from && trie->edges[slot].byte == byte) { return trie->edges[slot].to; }
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+static bool AddTrieNode(PatternTrie* trie)
+{
+    if (trie->node_count >= trie->node_capacity)
+    {
+        usize new_capacity = trie->node_capacity ? trie->node_capacity * 2 : 1024;
+        s32* new_patterns = (s32*)(TaggedRealloc(AllocationTag_MessageTable, trie->node_patterns, new_capacity * sizeof(s32)));
+        if (!new_patterns) { return false; }
+        trie->node_patterns = new_patterns;
+        trie->node_capacity = new_capacity;
+    }
+    trie->node_patterns[trie->node_count++] = -1;
+    return true;
+}
+
+// the edge hash is sized up front, every pattern byte is at most one new edge
+static bool BuildPatternTrie(MessageTable* message_table)
+{
+    PatternTrie* trie = &message_table->trie;
+    usize byte_count = 0;
+    for (usize p = 0; p < message_table->pattern_count; p++) { byte_count += message_table->patterns[p].length; }
+    
+    trie->edge_capacity = 1024;
+    while (trie->edge_capacity < byte_count * 2) { trie->edge_capacity *= 2; }
+    trie->edges = (PatternTrieEdge*)(TaggedCalloc(AllocationTag_MessageTable, trie->edge_capacity, sizeof(PatternTrieEdge)));
+    if (!trie->edges || !AddTrieNode(trie) || !AddTrieNode(trie)) { return false; }
+    
+    for (usize p = 0; p < message_table->pattern_count; p++)
+    {
+        SearchPattern* pattern = &message_table->patterns[p];
+        u32 node = pattern->case_insensitive ? 1 : 0;
+        for (usize i = 0; i < pattern->length; i++)
+        {
+            u8 byte = (u8)(pattern->text[i]);
+            u32 next = FindTrieEdge(trie, node, byte);
+            if (!next)
+            {
+                if (!AddTrieNode(trie)) { return false; }
+                next = (u32)(trie->node_count - 1);
+                
+                usize slot = HashTrieEdge(node, byte) & (trie->edge_capacity - 1);
+                while (trie->edges[slot].to) { slot = (slot + 1) & (trie->edge_capacity - 1); }
+                trie->edges[slot].from = node;
+                trie->edges[slot].to = next;
+                trie->edges[slot].byte = byte;
+                trie->edge_count++;
+            }
+            node = next;
+        }
+        // patterns are walked in table order, so the first one to claim a node is the one the pattern loop would find
+        if (trie->node_patterns[node] < 0) { trie->node_patterns[node] = (s32)(p); }
+    }
+    return true;
+}
+
+// symbol -1 and the pattern index as the keyword for regex pattern buckets
+static void GetBucketCombination(MessageTable* message_table, usize bucket_index, s32* symbol, s32* keyword)
+{
+    usize combination_count = message_table->symbols.size * message_table->keywords.size;
+    if (bucket_index < combination_count)
+    {
+        *symbol = (s32)(bucket_index / message_table->keywords.size);
+        *keyword = (s32)(bucket_index % message_table->keywords.size);
+    }
+    else
+    {
+        *symbol = -1;
+        *keyword = (s32)(bucket_index - combination_count);
+    }
+}
+
+static u64 HashBucketIndex(usize bucket_index)
+{
+    u64 hash = (u64)(bucket_index) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 31);
+}
+
+MessageBucket* FindBucket(MessageTable* message_table, usize bucket_index)
+{
+    if (!message_table->bucket_slot_capacity) { return 0; }
+    
+    usize mask = message_table->bucket_slot_capacity - 1;
+    usize slot = HashBucketIndex(bucket_index) & mask;
+    while (message_table->bucket_slots[slot])
+    {
+        MessageBucket* bucket = &message_table->message_buckets[message_table->bucket_slots[slot] - 1];
+        if (bucket->index == bucket_index) { return bucket; }
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+// swaps in empty slots and puts every bucket back in them, after growing or sorting
+static void RehashBuckets(MessageTable* message_table, u32* new_slots, usize slot_capacity)
+{
+    TaggedFree(message_table->bucket_slots);
+    message_table->bucket_slots = new_slots;
+    message_table->bucket_slot_capacity = slot_capacity;
+    
+    for (usize i = 0; i < message_table->message_bucket_count; i++)
+    {
+        usize slot = HashBucketIndex(message_table->message_buckets[i].index) & (slot_capacity - 1);
+        while (new_slots[slot]) { slot = (slot + 1) & (slot_capacity - 1); }
+        new_slots[slot] = (u32)(i + 1);
+    }
+}
+
+MessageBucket* AddBucket(MessageTable* message_table, usize bucket_index)
+{
+    MessageBucket* bucket = FindBucket(message_table, bucket_index);
+    if (bucket) { return bucket; }
+    if (bucket_index >= message_table->bucket_count) { return 0; }
+    
+    if (message_table->message_bucket_count >= message_table->message_bucket_capacity)
+    {
+        usize new_capacity = message_table->message_bucket_capacity ? message_table->message_bucket_capacity * 2 : 16;
+        MessageBucket* new_buckets = (MessageBucket*)(TaggedRealloc(AllocationTag_MessageTable, message_table->message_buckets, new_capacity * sizeof(MessageBucket)));
+        if (!new_buckets) { return 0; }
+        message_table->message_buckets = new_buckets;
+        message_table->message_bucket_capacity = new_capacity;
+    }
+    if ((message_table->message_bucket_count + 1) * 2 > message_table->bucket_slot_capacity)
+    {
+        usize new_capacity = message_table->bucket_slot_capacity ? message_table->bucket_slot_capacity * 2 : 64;
+        u32* new_slots = (u32*)(TaggedCalloc(AllocationTag_MessageTable, new_capacity, sizeof(u32)));
+        if (!new_slots) { return 0; }
+        RehashBuckets(message_table, new_slots, new_capacity);
+    }
+    
+    bucket = &message_table->message_buckets[message_table->message_bucket_count];
+    memset(bucket, 0, sizeof(MessageBucket));
+    bucket->index = bucket_index;
+    GetBucketCombination(message_table, bucket_index, &bucket->symbol, &bucket->keyword);
+    
+    usize slot = HashBucketIndex(bucket_index) & (message_table->bucket_slot_capacity - 1);
+    while (message_table->bucket_slots[slot]) { slot = (slot + 1) & (message_table->bucket_slot_capacity - 1); }
+    message_table->bucket_slots[slot] = (u32)(++message_table->message_bucket_count);
+    return bucket;
+}
+
+static int CompareBucketIndexes(const void* left, const void* right)
+{
+    usize left_index = ((const MessageBucket*)(left))->index;
+    usize right_index = ((const MessageBucket*)(right))->index;
+    return (left_index > right_index) - (left_index < right_index);
+}
+
+void SortBuckets(MessageTable* message_table)
+{
+    if (message_table->message_bucket_count < 2) { return; }
+    
+    // sorting moves the buckets, they stay where they are if the slots can't be rebuilt
+    u32* new_slots = (u32*)(TaggedCalloc(AllocationTag_MessageTable, message_table->bucket_slot_capacity, sizeof(u32)));
+    if (!new_slots) { return; }
+    qsort(message_table->message_buckets, message_table->message_bucket_count, sizeof(MessageBucket), CompareBucketIndexes);
+    RehashBuckets(message_table, new_slots, message_table->bucket_slot_capacity);
+}
+
 MessageTable* AllocateMessageTable(UserConfig* user_config)
 {
-    MessageTable* message_table = (MessageTable*)( malloc(sizeof(MessageTable)) );
+    MessageTable* message_table = (MessageTable*)( TaggedMalloc(AllocationTag_MessageTable, sizeof(MessageTable)) );
     if(!message_table) 
     { 
         LogDebug("AllocateMessageTable, failed to malloc message_table");
+        FreeUserConfig(user_config);
         return 0; 
     }
     memset(message_table, 0, sizeof(MessageTable));
@@ -76,268 +322,1965 @@ MessageTable* AllocateMessageTable(UserConfig* user_config)
         message_table->keywords = user_config->keywords;
         message_table->ignore_directories = user_config->ignore_directories;
         message_table->ignore_extensions = user_config->ignore_extensions;
+        message_table->regex_patterns = user_config->regex_patterns;
+        
+        // case insensitive keywords live at the end of the keyword list
+        usize case_sensitive_count = message_table->keywords.size;
+        StringVector_PushArray
+        (
+            &message_table->keywords, 
+            (const char**)(user_config->case_insensitive_keywords.data), 
+            user_config->case_insensitive_keywords.size
+        );
+        StringVector_Free(&user_config->case_insensitive_keywords);
+        
+        // everything it held belongs to the table now, from here a failure only has the table to free
         free(user_config);
+        
+        message_table->keyword_case_insensitive = (bool*)(TaggedCalloc(AllocationTag_MessageTable, message_table->keywords.size + 1, sizeof(bool)));
+        if (!message_table->keyword_case_insensitive)
+        {
+            LogDebug("AllocateMessageTable, failed to allocate keyword flags");
+            FreeMessageTable(message_table);
+            return 0;
+        }
+        for (usize k = case_sensitive_count; k < message_table->keywords.size; k++)
+        {
+            message_table->keyword_case_insensitive[k] = true;
+        }
     }
 
+    // callers check IsUserConfigUsable first, this only catches the ones that didn't
     if(message_table->symbols.size == 0 || message_table->keywords.size == 0)
     {
-        LogDebug("empty symbol or keyword table");
-        return 0;
+        LogDebug("empty symbol or keyword table");
+        FreeMessageTable(message_table);
+        return 0;
+    }
+
+    // patterns are compiled once here, a bad pattern only costs the patterns
+    if (message_table->regex_patterns.size > 0)
+    {
+        char error[256];
+        if (!RegexSet_Compile(&message_table->regex_set, (const char**)(message_table->regex_patterns.data), message_table->regex_patterns.size, error, sizeof(error)))
+        {
+            Log("Ignoring [patterns], %s\n", error);
+            StringVector_Free(&message_table->regex_patterns);
+        }
+    }
+
+    // buckets are made as their combinations are hit, see AddBucket
+    message_table->bucket_count = message_table->symbols.size * message_table->keywords.size + message_table->regex_patterns.size;
+    
+    if (!BuildSearchPatterns(message_table))
+    {
+        LogDebug("Failed to build search patterns");
+        FreeMessageTable(message_table);
+        return 0;
+    }
+    
+    message_table->large_vocabulary = message_table->pattern_count > LargeVocabularyPatterns;
+    if (message_table->large_vocabulary && !BuildPatternTrie(message_table))
+    {
+        LogDebug("Failed to build the pattern trie");
+        FreeMessageTable(message_table);
+        return 0;
+    }
+    
+#ifdef TODO_BAKED_MATCHER
+    message_table->use_baked_matcher = GetMatcherFingerprint(message_table) == BakedMatcher_Fingerprint;
+    LogDebug("AllocateMessageTable, %s\n", message_table->use_baked_matcher ? "using the baked matcher" : "config differs from the baked one, using the dynamic matcher");
+#endif
+    return message_table;  
+}
+
+static u64 HashBytes(u64 hash, const void* bytes, usize count)
+{
+    for (usize i = 0; i < count; i++)
+    {
+        hash ^= ((const u8*)(bytes))[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+u64 GetMatcherFingerprint(MessageTable* message_table)
+{
+    u64 hash = 0xCBF29CE484222325ull;
+    for (usize s = 0; s < message_table->symbols.size; s++)
+    {
+        hash = HashBytes(hash, message_table->symbols.data[s], StringLength(message_table->symbols.data[s]) + 1);
+    }
+    hash = HashBytes(hash, "\x1E", 1);
+    for (usize k = 0; k < message_table->keywords.size; k++)
+    {
+        u8 case_insensitive = message_table->keyword_case_insensitive && message_table->keyword_case_insensitive[k];
+        hash = HashBytes(hash, message_table->keywords.data[k], StringLength(message_table->keywords.data[k]) + 1);
+        hash = HashBytes(hash, &case_insensitive, 1);
+    }
+    return hash;
+}
+
+void FreeMessageTable(MessageTable* message_table)
+{
+    if(message_table)
+    {
+        for (usize i = 0; i < message_table->message_bucket_count; i++)
+        {
+            StringVector_Free(&message_table->message_buckets[i].strings);
+        }
+        TaggedFree(message_table->message_buckets);
+        TaggedFree(message_table->bucket_slots);
+        TaggedFree(message_table->trie.node_patterns);
+        TaggedFree(message_table->trie.edges);
+        for (usize i = 0; i < message_table->rollup_node_count; i++)
+        {
+            TaggedFree(message_table->rollup_nodes[i].path);
+            TaggedFree(message_table->rollup_nodes[i].counts);
+        }
+        TaggedFree(message_table->rollup_nodes);
+        TaggedFree(message_table->visited.slots);
+        FreeBaseline(&message_table->baseline);
+        for (usize i = 0; i < message_table->deadline_files.count; i++) { TaggedFree(message_table->deadline_files.entries[i].path); }
+        TaggedFree(message_table->deadline_files.entries);
+        TaggedFree(message_table->match_locations);
+        FreeReadBuffer(&message_table->read_buffer);
+        StringVector_Free(&message_table->context_files);
+        TaggedFree(message_table->patterns);
+        TaggedFree(message_table->pattern_text);
+        TaggedFree(message_table->keyword_case_insensitive);
+        StringVector_Free(&message_table->arguments.roots);
+        RegexSet_Free(&message_table->regex_set);
+        StringVector_Free(&message_table->regex_patterns);
+        StringVector_Free(&message_table->symbols);
+        StringVector_Free(&message_table->keywords);
+        StringVector_Free(&message_table->ignore_directories);
+        StringVector_Free(&message_table->ignore_extensions);
+        StringVector_Free(&message_table->skipped_directories);
+        StringVector_Free(&message_table->skipped_files);
+        StringVector_Free(&message_table->empty_files);
+        TaggedFree(message_table);
+    }
+    
+}
+
+
+bool ProcessUserRequest(MessageTable* message_table)
+{
+    if(!message_table) 
+    { 
+        Log("null message_table for user request. did you call AllocateMessageTable(user_config)?"); 
+        return false; 
+    }
+    
+    message_table->fail_on_keyword_index = -1;
+    if(message_table->arguments.fail_on_keyword)
+    {
+        for(usize k = 0; k < message_table->keywords.size; ++k)
+        {
+            if(StringCompare(message_table->keywords.data[k], message_table->arguments.fail_on_keyword) == 0)
+            {
+                message_table->fail_on_keyword_index = (s32)k;
+                break;
+            }
+        }
+        if(message_table->fail_on_keyword_index == -1)
+        {
+            Log("--fail-on keyword \"%s\" is not one of the searched keywords\n", message_table->arguments.fail_on_keyword);
+            return false;
+        }
+    }
+
+    message_table->deadline_end_ms = GetTimeMilliseconds() + message_table->arguments.deadline_ms;
+    
+    // a merge only reads partial results, the roots are the partial files
+    if (message_table->arguments.merge)
+    {
+        return MergePartialResults(message_table, &message_table->arguments.roots);
+    }
+    
+    // a diff names its own files, nothing in the working tree is read
+    if (message_table->arguments.diff)
+    {
+        File diff = {0};
+        bool from_stdin = StringCompare(message_table->arguments.diff, "-") == 0;
+        if (!(from_stdin ? FileOpenStandardInput(&diff) : FileOpen(&diff, message_table->arguments.diff, "rb")))
+        {
+            Log("--diff, could not open %s\n", message_table->arguments.diff);
+            return false;
+        }
+        ProcessUnifiedDiff(message_table, &diff);
+        FileClose(&diff);
+        return !message_table->scan_failed;
+    }
+    
+    // explicit roots are searched as given, a list of files goes through the ignore rules
+    for (usize i = 0; i < message_table->arguments.roots.size && !message_table->stop_requested; i++)
+    {
+        ProcessPath(message_table, message_table->arguments.roots.data[i]);
+    }
+    
+    if (message_table->arguments.files_from)
+    {
+        FileContents file_list = {0};
+        bool from_stdin = StringCompare(message_table->arguments.files_from, "-") == 0;
+        usize size = from_stdin ? GetStandardInputContents(&file_list) : GetFileContents(&file_list, message_table->arguments.files_from);
+        if (size > 0)
+        {
+            ProcessFileList(message_table, &file_list);
+            FreeFileContents(&file_list);
+        }
+        else
+        {
+            Log("--files-from %s is empty or could not be read\n", message_table->arguments.files_from);
+        }
+    }
+    else if (message_table->arguments.roots.size == 0)
+    {
+        ProcessPath(message_table, ".");
+    }
+    
+    if (message_table->arguments.deadline_ms)
+    {
+        ProcessDeadlineFiles(message_table);
+    }
+    return !message_table->scan_failed;
+}
+
+static u64 HashFileIdentity(u64 device, u64 inode)
+{
+    u64 hash = (device * 0x9E3779B97F4A7C15ull) ^ inode;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// false when the pair was already in the set
+static bool VisitedSet_Insert(VisitedSet* set, u64 device, u64 inode)
+{
+    if ((set->count + 1) * 2 > set->capacity)
+    {
+        usize new_capacity = set->capacity ? set->capacity * 2 : 1024;
+        u64* new_slots = (u64*)(TaggedCalloc(AllocationTag_MessageTable, new_capacity * 2, sizeof(u64)));
+        if (!new_slots) 
+        { 
+            // out of memory just means we stop deduplicating
+            return true; 
+        }
+        for (usize i = 0; i < set->capacity; i++)
+        {
+            u64 old_device = set->slots[i * 2];
+            u64 old_inode = set->slots[i * 2 + 1];
+            if (!old_device && !old_inode) { continue; }
+            usize slot = HashFileIdentity(old_device, old_inode) & (new_capacity - 1);
+            while (new_slots[slot * 2] || new_slots[slot * 2 + 1]) { slot = (slot + 1) & (new_capacity - 1); }
+            new_slots[slot * 2] = old_device;
+            new_slots[slot * 2 + 1] = old_inode;
+        }
+        TaggedFree(set->slots);
+        set->slots = new_slots;
+        set->capacity = new_capacity;
+    }
+    
+    usize slot = HashFileIdentity(device, inode) & (set->capacity - 1);
+    while (set->slots[slot * 2] || set->slots[slot * 2 + 1])
+    {
+        if (set->slots[slot * 2] == device && set->slots[slot * 2 + 1] == inode) { return false; }
+        slot = (slot + 1) & (set->capacity - 1);
+    }
+    set->slots[slot * 2] = device;
+    set->slots[slot * 2 + 1] = inode;
+    set->count++;
+    return true;
+}
+
+// true the first time a file or directory is reached, entries without an identity always pass
+// only directories and files with more than one name go in the set, a file with one name can only be reached once
+// so the set grows with the directories and links in the tree, not with every file searched
+static bool MarkVisited(MessageTable* message_table, const char* path, FileType type, u64 device, u64 inode, u32 link_count)
+{
+    if (!device && !inode) { return true; }
+    if (type != FileType_Directory && link_count <= 1) { return true; }
+    if (VisitedSet_Insert(&message_table->visited, device, inode)) { return true; }
+    
+    LogDebug("%s was already searched through another link, skipping\n", path);
+    message_table->deduplicated_count++;
+    return false;
+}
+
+// --inode-order, a directory's files are searched after its entries are read, sorted by inode
+// on most file systems that is close to where the data sits on disk, so a cold scan seeks forward instead of at random
+// the next few files get a readahead hint while the current one is matched
+#define ReadaheadFileCount 4
+
+static void FileBatch_Add(FileBatch* batch, const char* file_path, u64 inode, u64 modified_time, u64 size)
+{
+    if (batch->count >= batch->capacity)
+    {
+        usize new_capacity = batch->capacity ? batch->capacity * 2 : 64;
+        FileBatchEntry* new_entries = (FileBatchEntry*)(TaggedRealloc(AllocationTag_MessageTable, batch->entries, new_capacity * sizeof(FileBatchEntry)));
+        if (!new_entries) { return; }
+        batch->entries = new_entries;
+        batch->capacity = new_capacity;
+    }
+    
+    usize length = StringLength(file_path);
+    char* path = (char*)(TaggedMalloc(AllocationTag_MessageTable, length + 1));
+    if (!path) { return; }
+    memcpy(path, file_path, length + 1);
+    
+    batch->entries[batch->count].path = path;
+    batch->entries[batch->count].inode = inode;
+    batch->entries[batch->count].modified_time = modified_time;
+    batch->entries[batch->count].size = size;
+    batch->count++;
+    if (inode) { batch->has_inodes = true; }
+}
+
+static void FileBatch_Free(FileBatch* batch)
+{
+    for (usize i = 0; i < batch->count; i++) { TaggedFree(batch->entries[i].path); }
+    TaggedFree(batch->entries);
+    memset(batch, 0, sizeof(FileBatch));
+}
+
+static int CompareInodes(const void* left, const void* right)
+{
+    u64 left_inode = ((const FileBatchEntry*)(left))->inode;
+    u64 right_inode = ((const FileBatchEntry*)(right))->inode;
+    return (left_inode > right_inode) - (left_inode < right_inode);
+}
+
+static void ProcessFileBatch(MessageTable* message_table, FileBatch* batch)
+{
+    // without inodes there is nothing to sort by, and qsort isn't stable, so the files keep their listing order
+    if (batch->count > 1 && batch->has_inodes) { qsort(batch->entries, batch->count, sizeof(FileBatchEntry), CompareInodes); }
+    
+    for (usize i = 0; i < batch->count && i < ReadaheadFileCount; i++) { PrefetchFile(batch->entries[i].path); }
+    for (usize i = 0; i < batch->count && !message_table->stop_requested; i++)
+    {
+        if (i + ReadaheadFileCount < batch->count) { PrefetchFile(batch->entries[i + ReadaheadFileCount].path); }
+        ProcessFile(message_table, batch->entries[i].path, batch->entries[i].size);
+    }
+    FileBatch_Free(batch);
+}
+
+// --deadline, checked between files and directory entries, a file that was started is always finished
+static bool DeadlinePassed(MessageTable* message_table)
+{
+    if (!message_table->arguments.deadline_ms) { return false; }
+    if (message_table->deadline_reached) { return true; }
+    if (GetTimeMilliseconds() < message_table->deadline_end_ms) { return false; }
+    
+    message_table->deadline_reached = true;
+    message_table->stop_requested = true;
+    return true;
+}
+
+// newest first
+static int CompareModifiedTimes(const void* left, const void* right)
+{
+    u64 left_time = ((const FileBatchEntry*)(left))->modified_time;
+    u64 right_time = ((const FileBatchEntry*)(right))->modified_time;
+    return (left_time < right_time) - (left_time > right_time);
+}
+
+void ProcessDeadlineFiles(MessageTable* message_table)
+{
+    FileBatch* batch = &message_table->deadline_files;
+    if (batch->count > 1) { qsort(batch->entries, batch->count, sizeof(FileBatchEntry), CompareModifiedTimes); }
+    
+    usize searched = 0;
+    while (searched < batch->count && !message_table->stop_requested && !DeadlinePassed(message_table))
+    {
+        ProcessFile(message_table, batch->entries[searched].path, batch->entries[searched].size);
+        searched++;
+    }
+    message_table->deadline_unsearched_count = batch->count - searched;
+    FileBatch_Free(batch);
+}
+
+// files reached outside of a directory walk, --deadline holds them back so the newest go first
+static void SearchOrQueueFile(MessageTable* message_table, DirectoryEntry* entry)
+{
+    if (message_table->arguments.deadline_ms) 
+    { 
+        FileBatch_Add(&message_table->deadline_files, entry->path, entry->inode, entry->modified_time, entry->size); 
+    }
+    else { ProcessFile(message_table, entry->path, entry->size); }
+}
+
+void ProcessPath(MessageTable* message_table, const char* path)
+{
+    DirectoryEntry entry = {0};
+    StringCopy_NullTerminate(entry.path, path, sizeof(entry.path));
+    if (!GetPathInfo(path, &entry) || entry.type == FileType_Other)
+    {
+        Log("Skipping %s, not a file or directory\n", path);
+        return;
+    }
+    if (!MarkVisited(message_table, entry.path, entry.type, entry.device, entry.inode, entry.link_count)) { return; }
+    
+    // --one-file-system stays on the device each root lives on
+    message_table->root_device = entry.device;
+    if (entry.type == FileType_Directory)
+    {
+        ProcessDirectory(message_table, path);
+    }
+    else
+    {
+        SearchOrQueueFile(message_table, &entry);
+    }
+}
+
+// --shard, fnv-1a of the path as it was reached, so every machine given the same roots agrees on who searches what
+static bool IsInShard(MessageTable* message_table, const char* filename)
+{
+    if (message_table->arguments.shard_count == 0) { return true; }
+    
+    u64 hash = 0xCBF29CE484222325ull;
+    for (const char* c = filename; *c; c++)
+    {
+        hash ^= (u8)(*c);
+        hash *= 0x100000001B3ull;
+    }
+    return (hash % message_table->arguments.shard_count) == message_table->arguments.shard_index;
+}
+
+// returns -1 if the file's extension is not in the extension list in the table
+static s32 FindIgnoreExtensionIndex(MessageTable* message_table, const char* file)
+{
+    if(!message_table || !file) { return false; }
+    for(s32 i = 0; i < message_table->ignore_extensions.size; ++i)
+    {
+        const char* extension = message_table->ignore_extensions.data[i];
+        if(StringEndsWith(file, extension))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static s32 FindIgnoreDirectoryIndex(MessageTable* message_table, const char* directory)
+{
+    if(!message_table || !directory) { return -1; }
+    for(s32 i = 0; i < message_table->ignore_directories.size; ++i)
+    {
+        if(StringCompare(directory, message_table->ignore_directories.data[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// true if any directory along the path is in the ignore list
+static bool IsInIgnoredDirectory(MessageTable* message_table, char* path)
+{
+    char* component = path;
+    for (char* c = path; *c; c++)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            char separator = *c;
+            *c = '\0';
+            bool ignored = FindIgnoreDirectoryIndex(message_table, component) != -1;
+            *c = separator;
+            if (ignored) { return true; }
+            component = c + 1;
+        }
+    }
+    return false;
+}
+
+// the list's root is the working directory, only the directories below it go through the ignore rules
+// relative paths are all below it, an absolute path inside it is checked from there
+// an absolute path outside it has no root, it is searched as given like a root on the command line
+static char* FindIgnoreCheckStart(DirectoryInfo* working_directory, usize working_length, char* path)
+{
+    bool absolute = (path[0] == '/' || path[0] == '\\' || (path[0] && path[1] == ':'));
+    if (!absolute) { return path; }
+    if (working_length == 0 || strncmp(path, working_directory->path, working_length) != 0) { return 0; }
+    
+    // the working directory is / or c:\ on its own, every absolute path is inside it
+    char last = working_directory->path[working_length - 1];
+    if (last == '/' || last == '\\') { return path + working_length; }
+    if (path[working_length] == '/' || path[working_length] == '\\') { return path + working_length + 1; }
+    return 0;
+}
+
+void ProcessFileList(MessageTable* message_table, FileContents* file_list)
+{
+    char* current = file_list->memory.buffer;
+    char* end = current + file_list->memory.size;
+    
+    // -z / -print0 style lists are nul separated, anything else is one path per line
+    bool nul_separated = memchr(current, '\0', file_list->memory.size) != 0;
+    DirectoryEntry entry = {0};
+    
+    DirectoryInfo working_directory = {0};
+    usize working_length = GetCurrentDirectoryInfo(&working_directory) ? StringLength(working_directory.path) : 0;
+    while (working_length > 1 && (working_directory.path[working_length - 1] == '/' || working_directory.path[working_length - 1] == '\\')) { working_length--; }
+    
+    while (current < end && !message_table->stop_requested)
+    {
+        char* path_end = current;
+        if (nul_separated)
+        {
+            while (path_end < end && *path_end != '\0') { path_end++; }
+        }
+        else
+        {
+            while (path_end < end && *path_end != '\n' && *path_end != '\r') { path_end++; }
+        }
+        *path_end = '\0';
+        
+        if (path_end > current)
+        {
+            const char* filename = strrchr(current, '/');
+            filename = filename ? filename + 1 : current;
+            
+            char* check_from = FindIgnoreCheckStart(&working_directory, working_length, current);
+            if (check_from && IsInIgnoredDirectory(message_table, check_from))
+            {
+                LogDebug("ProcessFileList, %s is in an ignored directory\n", current);
+            }
+            else if (FindIgnoreExtensionIndex(message_table, filename) != -1)
+            {
+                if (IsInShard(message_table, current)) { StringVector_PushBack(&message_table->skipped_files, filename); }
+            }
+            else if (GetPathInfo(current, &entry) && entry.type == FileType_File)
+            {
+                StringCopy_NullTerminate(entry.path, current, sizeof(entry.path));
+                if (MarkVisited(message_table, entry.path, entry.type, entry.device, entry.inode, entry.link_count)) { SearchOrQueueFile(message_table, &entry); }
+            }
+            else
+            {
+                // deleted files show up in most change lists, not worth a warning
+                LogDebug("ProcessFileList, skipping %s, not a file\n", current);
+            }
+        }
+        current = path_end + 1;
+    }
+}
+
+typedef struct ProcessLineResults
+{
+    s32 symbol_index;
+    s32 keyword_index;
+    usize bucket_index;
+    const char* at_pos;
+    usize length;     // from at_pos to the end of the line
+    RegexMatch regex; // group_count is 0 unless a [patterns] entry matched
+}ProcessLineResults;
+
+// regex patterns win over [symbol][keyword] matches that start at or after them
+static void ProcessLinePatterns(MessageTable* message_table, RegexScratch* regex_scratch, const char* line, const char* line_end, ProcessLineResults* results)
+{
+    s32 pattern = RegexSet_Find(&message_table->regex_set, line, line_end);
+    if (pattern < 0) { return; }
+    
+    RegexMatch match;
+    if (!RegexSet_Match(&message_table->regex_set, regex_scratch, pattern, line, line_end, &match)) { return; }
+    if (results->at_pos && results->at_pos < match.start) { return; }
+    
+    results->symbol_index = -1;
+    results->keyword_index = -1;
+    results->bucket_index = message_table->symbols.size * message_table->keywords.size + pattern;
+    results->at_pos = match.start;
+    results->length = line_end - match.start;
+    results->regex = match;
+}
+
+// walks the trie from root as far as text goes, every pattern end passed on the way is a candidate
+// returns the lowest pattern index that ends on a word boundary, the same one the pattern loop would pick
+static s32 MatchTrieAt(PatternTrie* trie, u32 root, const char* text, usize available, bool folded)
+{
+    s32 best = -1;
+    u32 node = root;
+    for (usize i = 0; i < available; i++)
+    {
+        u8 byte = (u8)(folded ? FoldCase(text[i]) : text[i]);
+        node = FindTrieEdge(trie, node, byte);
+        if (!node) { break; }
+        
+        s32 pattern = trie->node_patterns[node];
+        if (pattern < 0 || (best >= 0 && pattern > best)) { continue; }
+        
+        char next_char = (i + 1 < available) ? text[i + 1] : '\0';
+        bool is_alnum = isalpha((u8)(next_char)) || isdigit((u8)(next_char));
+        if (!is_alnum && next_char != '_') { best = pattern; }
+    }
+    return best;
+}
+
+// finds the leftmost [symbol][keyword] in [line, line_end)
+// candidates are found by searching for the first byte of every symbol at once, then each pattern is checked there
+ProcessLineResults ProcessLine(MessageTable* message_table, RegexScratch* regex_scratch, const char* line, const char* line_end)
+{
+    ProcessLineResults results;
+    memset(&results, 0, sizeof(results));
+    results.symbol_index = -1;
+    results.keyword_index = -1;
+    if(!message_table) { return results; }
+    
+    if (message_table->regex_set.pattern_count > 0)
+    {
+        ProcessLinePatterns(message_table, regex_scratch, line, line_end, &results);
+    }
+    
+    // only candidates left of a regex match can beat it
+    const char* search_end = results.at_pos ? results.at_pos : line_end;
+    
+    const char* current = line;
+    
+#ifdef TODO_BAKED_MATCHER
+    // same search with every symbol and keyword compiled in, no pattern loop and no setup
+    if (message_table->use_baked_matcher)
+    {
+        while (current < search_end)
+        {
+            current = BakedFindSymbol(current, search_end);
+            if (current >= search_end) { break; }
+            
+            s32 symbol = -1;
+            s32 keyword = -1;
+            if (BakedMatchAt(current, line_end - current, &symbol, &keyword))
+            {
+                memset(&results, 0, sizeof(results));
+                results.symbol_index = symbol;
+                results.keyword_index = keyword;
+                results.bucket_index = symbol * message_table->keywords.size + keyword;
+                results.at_pos = current;
+                results.length = line_end - current;
+                return results;
+            }
+            current++;
+        }
+        return results;
+    }
+#endif
+
+    while (current < search_end)
+    {
+        current = FindFirstOfBytes(current, search_end, message_table->symbol_first_bytes, message_table->symbol_first_byte_count);
+        if (current >= search_end) { break; }
+        
+        usize available = line_end - current;
+        if (message_table->large_vocabulary)
+        {
+            s32 found = MatchTrieAt(&message_table->trie, 0, current, available, false);
+            s32 found_folded = MatchTrieAt(&message_table->trie, 1, current, available, true);
+            if (found < 0 || (found_folded >= 0 && found_folded < found)) { found = found_folded; }
+            if (found >= 0)
+            {
+                SearchPattern* pattern = &message_table->patterns[found];
+                memset(&results, 0, sizeof(results));
+                results.symbol_index = pattern->symbol;
+                results.keyword_index = pattern->keyword;
+                results.bucket_index = pattern->symbol * message_table->keywords.size + pattern->keyword;
+                results.at_pos = current;
+                results.length = available;
+                return results;
+            }
+            current++;
+            continue;
+        }
+        
+        for (usize p = 0; p < message_table->pattern_count; p++) 
+        {
+            SearchPattern* pattern = &message_table->patterns[p];
+            if (pattern->length > available) { continue; }
+            
+            bool found = pattern->case_insensitive ? 
+                StringMatchesFolded(current, available, pattern->text, pattern->length) : 
+                (memcmp(current, pattern->text, pattern->length) == 0);
+            if (found) 
+            {
+                char next_char = (pattern->length < available) ? current[pattern->length] : '\0';
+                bool is_alnum = isalpha((u8)(next_char)) || isdigit((u8)(next_char));
+                if (!is_alnum && next_char != '_') 
+                {
+                    memset(&results, 0, sizeof(results));
+                    results.symbol_index = pattern->symbol;
+                    results.keyword_index = pattern->keyword;
+                    results.bucket_index = pattern->symbol * message_table->keywords.size + pattern->keyword;
+                    results.at_pos = current;
+                    results.length = available;
+                    return results;
+                }
+            }
+        }
+        current++;
+    }
+    return results;
+}
+
+// every match goes through here so the early out modes only need to be handled once
+static void RecordMatch(MessageTable* message_table, ProcessLineResults* results, const char* filename, s32 line_number)
+{
+    usize type_index = results->bucket_index;
+    MessageBucket* bucket = AddBucket(message_table, type_index);
+    if (!bucket)
+    {
+        LogDebug("RecordMatch, out of memory for a new bucket, the match is dropped\n");
+        return;
+    }
+    bucket->count++;
+    message_table->match_count++;
+    if (message_table->arguments.save_baseline || message_table->arguments.diff_baseline)
+    {
+        AddBaselineEntry(message_table, type_index, filename, line_number, results->at_pos, results->length);
+    }
+    if (message_table->rollup_counts) { message_table->rollup_counts[type_index]++; }
+    
+    bool fail = (message_table->fail_on_keyword_index >= 0 && results->keyword_index == message_table->fail_on_keyword_index);
+    
+    if (message_table->match_callback)
+    {
+        TodoFinderMatch match = {0};
+        match.path = filename;
+        match.line_number = line_number;
+        match.symbol = (bucket->symbol >= 0) ? message_table->symbols.data[bucket->symbol] : 0;
+        match.keyword = (bucket->symbol >= 0) ? message_table->keywords.data[bucket->keyword] : message_table->regex_patterns.data[bucket->keyword];
+        match.text = results->at_pos;
+        match.text_length = results->length;
+        if (message_table->match_callback(&match, message_table->match_user_data) != 0)
+        {
+            message_table->stop_requested = true;
+        }
+    }
+    // a failing match is always kept so the user can see what stopped the scan
+    else if (!message_table->arguments.count_only || fail)
+    {
+        char buffer[1024];
+        usize length = StringLength(filename);
+        s32 text_length = (results->length < sizeof(buffer)) ? (s32)(results->length) : (s32)(sizeof(buffer));
+        s32 used = snprintf(buffer, sizeof(buffer), "%-48.*s %4d: %.*s", (s32)(length), filename, line_number, text_length, results->at_pos);
+        
+        // regex capture groups go after the line as [$1=owner $2=...]
+        for (usize g = 1; g <= results->regex.group_count && used > 0 && used < (s32)(sizeof(buffer)); g++)
+        {
+            const char* group_start = results->regex.saved[g * 2];
+            const char* group_end = results->regex.saved[g * 2 + 1];
+            s32 group_length = (group_start && group_end) ? (s32)(group_end - group_start) : 0;
+            used += snprintf
+            (
+                buffer + used, sizeof(buffer) - used, "%s$%zu=%.*s%s", 
+                (g == 1) ? "    [" : " ", g, group_length, group_start ? group_start : "", (g == results->regex.group_count) ? "]" : ""
+            );
+        }
+        if (used > 0 && used < (s32)(sizeof(buffer)) - 1) 
+        { 
+            buffer[used] = '\n'; 
+            buffer[used + 1] = '\0'; 
+        }
+        else
+        {
+            buffer[sizeof(buffer) - 2] = '\n';
+        }
+        StringVector_PushBack(&bucket->strings, buffer);
+    }
+    
+    if (fail)
+    {
+        message_table->exit_code = 1;
+        message_table->stop_requested = true;
+    }
+    if (message_table->arguments.max_results && message_table->match_count >= message_table->arguments.max_results)
+    {
+        message_table->stop_requested = true;
+    }
+}
+
+// everything that carries over from one line to the next while scanning a file
+// lexed_to is where the comment lexer has got to in the current buffer, streamed files move it along every chunk
+typedef struct ScanState
+{
+    const char* display_path;
+    s32 line_number;
+    CommentLexer lexer;
+    bool comments_only;
+    const char* lexed_to;
+    bool hit_nul;
+    RegexScratch* regex_scratch; // the table's own unless this is a large file worker
+    
+    // -C, set when the whole file is in one buffer so a line's offset is just line - context_base
+    const char* context_base;
+    s32 context_file; // -1 until the first kept match
+    
+    // streaming only, holds a line that was split across chunks
+    char* carry;
+    usize carry_size;
+    usize carry_capacity;
+    bool continuation; // searching the start of a line cut at MaxStreamLine, it is counted when its ending shows up
+    
+    // a large file worker's chunk, matches wait here for the merge instead of going into the table
+    struct DeferredMatches* deferred;
+} ScanState;
+
+// line_number is counted from the start of the chunk, the merge adds the lines of every chunk before it
+typedef struct DeferredMatch
+{
+    ProcessLineResults results;
+    const char* line;
+    s32 line_number;
+} DeferredMatch;
+
+typedef struct DeferredMatches
+{
+    DeferredMatch* matches;
+    usize count;
+    usize capacity;
+} DeferredMatches;
+
+// lines longer than this are cut when streaming, a match split across the cut is missed
+#define MaxStreamLine (64 * 1024)
+
+static void BeginScan(MessageTable* message_table, ScanState* state, const char* display_path, const char* language_path)
+{
+    memset(state, 0, sizeof(ScanState));
+    state->display_path = display_path;
+    state->line_number = 1;
+    state->regex_scratch = &message_table->regex_set.scratch;
+    state->comments_only = message_table->arguments.comments_only && CommentLexer_Init(&state->lexer, GetCommentLanguage(language_path));
+}
+
+static void AddMatchLocation(MessageTable* message_table, ScanState* state, usize bucket_index, usize message_index, u64 line_offset)
+{
+    if (message_table->match_location_count >= message_table->match_location_capacity)
+    {
+        usize new_capacity = message_table->match_location_capacity ? message_table->match_location_capacity * 2 : 256;
+        MatchLocation* new_locations = (MatchLocation*)(TaggedRealloc(AllocationTag_MessageTable, message_table->match_locations, new_capacity * sizeof(MatchLocation)));
+        if (!new_locations) { return; }
+        message_table->match_locations = new_locations;
+        message_table->match_location_capacity = new_capacity;
+    }
+    
+    // files are only remembered once they have a match
+    if (state->context_file < 0)
+    {
+        state->context_file = (s32)(message_table->context_files.size);
+        StringVector_PushBack(&message_table->context_files, state->display_path);
+    }
+    
+    MatchLocation* location = &message_table->match_locations[message_table->match_location_count++];
+    location->bucket = (u32)(bucket_index);
+    location->message = (u32)(message_index);
+    location->file = (u32)(state->context_file);
+    location->line_number = state->line_number;
+    location->line_offset = line_offset;
+}
+
+static void KeepMatch(MessageTable* message_table, ScanState* state, ProcessLineResults* results, const char* line)
+{
+    MessageBucket* bucket = FindBucket(message_table, results->bucket_index);
+    usize kept = bucket ? bucket->strings.size : 0;
+    RecordMatch(message_table, results, state->display_path, state->line_number);
+    bucket = FindBucket(message_table, results->bucket_index);
+    if (state->context_base && bucket && bucket->strings.size > kept)
+    {
+        AddMatchLocation(message_table, state, results->bucket_index, kept, (u64)(line - state->context_base));
+    }
+}
+
+// runs on a worker, nothing here touches the table
+static void DeferMatch(DeferredMatches* deferred, ProcessLineResults* results, const char* line, s32 line_number)
+{
+    if (deferred->count >= deferred->capacity)
+    {
+        usize new_capacity = deferred->capacity ? deferred->capacity * 2 : 256;
+        DeferredMatch* new_matches = (DeferredMatch*)(TaggedRealloc(AllocationTag_MessageTable, deferred->matches, new_capacity * sizeof(DeferredMatch)));
+        if (!new_matches)
+        {
+            LogDebug("DeferMatch, out of memory for a deferred match, the match is dropped\n");
+            return;
+        }
+        deferred->matches = new_matches;
+        deferred->capacity = new_capacity;
+    }
+    
+    DeferredMatch* match = &deferred->matches[deferred->count++];
+    match->results = *results;
+    match->line = line;
+    match->line_number = line_number;
+}
+
+static void ProcessLineMatches(MessageTable* message_table, ScanState* state, const char* line, const char* line_end)
+{
+    const char* search_from = line;
+    while (line_end > search_from) 
+    {
+        ProcessLineResults results = ProcessLine(message_table, state->regex_scratch, search_from, line_end);
+        if (!results.at_pos) { break; }
+        
+        // the lexer is only advanced when a candidate shows up, files without matches never pay for it
+        if (state->comments_only)
+        {
+            CommentLexer_Advance(&state->lexer, state->lexed_to, results.at_pos);
+            state->lexed_to = results.at_pos;
+            if (!CommentLexer_InComment(&state->lexer))
+            {
+                // keep looking, a later match on this line may still be in a comment
+                search_from = results.at_pos + 1;
+                continue;
+            }
+        }
+        
+        if (state->deferred) { DeferMatch(state->deferred, &results, line, state->line_number); }
+        else { KeepMatch(message_table, state, &results, line); }
+        break;
+    }
+}
+
+// scans every line in [start, end)
+// when more data is coming (final is false) the trailing partial line is left alone and a pointer to it is returned
+// a nul byte ends the scan, that's a binary file
+static const char* ScanLines(MessageTable* message_table, ScanState* state, const char* start, const char* end, bool final)
+{
+    const char* current = start;
+    if (!state->lexed_to || state->lexed_to < start || state->lexed_to > end) { state->lexed_to = start; }
+    
+    while (current < end && !message_table->stop_requested) 
+    {
+        // handle line endings
+        const char* line_end = current;
+        while (line_end < end && *line_end && *line_end != '\n' && *line_end != '\r') { line_end++; }
+        
+        // a \r at the end of a chunk might be the first half of \r\n
+        bool complete = (line_end < end) && !(*line_end == '\r' && line_end + 1 == end && !final);
+        if (!complete && !final) { break; }
+        
+        ProcessLineMatches(message_table, state, current, line_end);
+        
+        if (line_end < end && *line_end == '\0') 
+        { 
+            state->hit_nul = true; 
+            current = end;
+            break; 
+        }
+        
+        current = line_end;
+        if (current < end && *current == '\r') current++;
+        if (current < end && *current == '\n') current++;
+        if (line_end < end || !state->continuation) { state->line_number++; }
+    }
+    return current;
+}
+
+// the buffer is about to go away, catch the lexer up so it can carry on in the next one
+static void LeaveBuffer(ScanState* state, const char* consumed_to)
+{
+    if (state->comments_only && state->lexed_to && consumed_to > state->lexed_to)
+    {
+        CommentLexer_Advance(&state->lexer, state->lexed_to, consumed_to);
+    }
+    state->lexed_to = 0;
+}
+
+static bool AppendCarry(ScanState* state, const char* data, usize size)
+{
+    if (state->carry_size + size > state->carry_capacity)
+    {
+        usize new_capacity = state->carry_capacity ? state->carry_capacity : 4096;
+        while (new_capacity < state->carry_size + size) { new_capacity *= 2; }
+        char* new_carry = (char*)(TaggedRealloc(AllocationTag_FileContents, state->carry, new_capacity));
+        if (!new_carry) { return false; }
+        state->carry = new_carry;
+        state->carry_capacity = new_capacity;
+    }
+    memcpy(state->carry + state->carry_size, data, size);
+    state->carry_size += size;
+    return true;
+}
+
+// [start, end) is the start of one line with no ending yet, too long to carry
+static void ScanLongLine(MessageTable* message_table, ScanState* state, const char* start, const char* end)
+{
+    state->continuation = true;
+    const char* consumed = ScanLines(message_table, state, start, end, true);
+    state->continuation = false;
+    LeaveBuffer(state, consumed);
+}
+
+// feeds the next chunk of a streamed file, lines are scanned in place where possible
+// only a line split across chunks gets copied
+static void StreamScan(MessageTable* message_table, ScanState* state, const char* data, usize size)
+{
+    if (state->hit_nul || size == 0) { return; }
+    const char* end = data + size;
+    
+    if (state->carry_size > 0)
+    {
+        // finish the split line, up to and including its line ending
+        // a carry ending in \r already has its ending, only a \n right after it still belongs to it
+        const char* line_end = data;
+        if (state->carry[state->carry_size - 1] != '\r')
+        {
+            while (line_end < end && *line_end && *line_end != '\n' && *line_end != '\r') { line_end++; }
+            if (line_end == end || (*line_end == '\r' && line_end + 1 == end))
+            {
+                // no line ending yet, or a \r that might be the first half of \r\n
+                if (!AppendCarry(state, data, end - data)) { state->carry_size = 0; }
+                if (state->carry_size >= MaxStreamLine && line_end == end)
+                {
+                    ScanLongLine(message_table, state, state->carry, state->carry + state->carry_size);
+                    state->carry_size = 0;
+                }
+                return;
+            }
+            if (*line_end == '\r') { line_end++; }
+        }
+        if (line_end < end && (*line_end == '\n' || *line_end == '\0')) { line_end++; }
+        
+        if (!AppendCarry(state, data, line_end - data)) { state->carry_size = 0; }
+        data = line_end;
+        
+        const char* consumed = ScanLines(message_table, state, state->carry, state->carry + state->carry_size, true);
+        LeaveBuffer(state, consumed);
+        state->carry_size = 0;
+        if (state->hit_nul) { return; }
+    }
+    
+    const char* consumed = ScanLines(message_table, state, data, end, false);
+    LeaveBuffer(state, consumed);
+    if (consumed < end && !state->hit_nul)
+    {
+        if (end - consumed >= MaxStreamLine)
+        {
+            // a trailing \r waits in the carry, it may be the first half of \r\n
+            const char* cut = (end[-1] == '\r') ? end - 1 : end;
+            ScanLongLine(message_table, state, consumed, cut);
+            consumed = cut;
+        }
+        if (consumed < end && !AppendCarry(state, consumed, end - consumed)) { state->carry_size = 0; }
+    }
+}
+
+static void EndStreamScan(MessageTable* message_table, ScanState* state)
+{
+    if (state->carry_size > 0 && !state->hit_nul)
+    {
+        ScanLines(message_table, state, state->carry, state->carry + state->carry_size, true);
+    }
+    TaggedFree(state->carry);
+    state->carry = 0;
+    state->carry_size = 0;
+    state->carry_capacity = 0;
+}
+
+// .gz files are inflated a chunk at a time straight into the line scanner, never all at once
+// line numbers are lines of the decompressed text
+static void ProcessGzipFile(MessageTable* message_table, const char* filename)
+{
+    GzipReader* reader = (GzipReader*)(TaggedMalloc(AllocationTag_FileContents, sizeof(GzipReader)));
+    if (!reader || !GzipOpen(reader, filename))
+    {
+        TaggedFree(reader);
+        StringVector_PushBack(&message_table->empty_files, filename);
+        return;
+    }
+    
+    // comment lexer picks the language from the name without .gz
+    char language_path[MaxPath];
+    usize length = StringCopy_NullTerminate(language_path, filename, sizeof(language_path));
+    if (length >= 3) { language_path[length - 3] = '\0'; }
+    
+    ScanState state;
+    BeginScan(message_table, &state, filename, language_path);
+    
+    char chunk[16384];
+    usize total = 0;
+    while (!message_table->stop_requested && !state.hit_nul)
+    {
+        usize read = GzipRead(reader, (u8*)(chunk), sizeof(chunk));
+        if (read == 0) { break; }
+        total += read;
+        StreamScan(message_table, &state, chunk, read);
+    }
+    EndStreamScan(message_table, &state);
+    
+    if (reader->error) { Log("Stopped reading %s, the file is damaged or truncated\n", filename); }
+    else if (total == 0) { StringVector_PushBack(&message_table->empty_files, filename); }
+    GzipClose(reader);
+    TaggedFree(reader);
+}
+
+// utf-16 files are converted to utf-8 a chunk at a time and streamed, the converted text is never held all at once
+// no context lines, offsets into the converted text don't point into the file
+static void ScanUtf16(MessageTable* message_table, const char* filename, const u8* data, usize size, Utf16Order order)
+{
+    ScanState state;
+    BeginScan(message_table, &state, filename, filename);
+    
+    char chunk[16384];
+    const u8* end = data + size;
+    while (!message_table->stop_requested && !state.hit_nul)
+    {
+        usize converted = TranscodeUtf16(&data, end, order, chunk, sizeof(chunk));
+        if (converted == 0) { break; }
+        StreamScan(message_table, &state, chunk, converted);
+    }
+    EndStreamScan(message_table, &state);
+}
+
+static usize ReadFromFile(void* stream, u8* destination, usize count)
+{
+    MemoryBuffer buffer = { (char*)(destination), count };
+    return FileRead(&buffer, count, (File*)(stream));
+}
+
+static usize ReadFromGzip(void* stream, u8* destination, usize count)
+{
+    return GzipRead((GzipReader*)(stream), destination, count);
+}
+
+static bool IsTarPath(const char* filename)
+{
+    return StringEndsWith(filename, ".tar") || StringEndsWith(filename, ".tar.gz") || StringEndsWith(filename, ".tgz");
+}
+
+// tar members are scanned as they stream past, matches are reported as archive.tar:dir/file.c
+// members go through the same directory and extension ignore rules as files on disk
+static void ProcessTarFile(MessageTable* message_table, const char* filename)
+{
+    File file = {0};
+    GzipReader* gzip = 0;
+    TarReader reader;
+    
+    if (StringEndsWith(filename, ".tar"))
+    {
+        if (!FileOpen(&file, filename, "rb"))
+        {
+            StringVector_PushBack(&message_table->empty_files, filename);
+            return;
+        }
+        TarOpen(&reader, ReadFromFile, &file);
+    }
+    else
+    {
+        gzip = (GzipReader*)(TaggedMalloc(AllocationTag_FileContents, sizeof(GzipReader)));
+        if (!gzip || !GzipOpen(gzip, filename))
+        {
+            TaggedFree(gzip);
+            StringVector_PushBack(&message_table->empty_files, filename);
+            return;
+        }
+        TarOpen(&reader, ReadFromGzip, gzip);
+    }
+    
+    TarMember member;
+    char display_path[MaxPath];
+    char chunk[16384];
+    usize member_count = 0;
+    while (!message_table->stop_requested && TarNextMember(&reader, &member))
+    {
+        if (member.type != FileType_File) { continue; }
+        member_count++;
+        
+        const char* member_name = strrchr(member.path, '/');
+        member_name = member_name ? member_name + 1 : member.path;
+        s32 display_length = snprintf(display_path, sizeof(display_path), "%s:%s", filename, member.path);
+        if (display_length < 0 || (usize)(display_length) >= sizeof(display_path))
+        {
+            Log("Skipping %s in %s, the combined path is longer than %d bytes\n", member.path, filename, (s32)(sizeof(display_path) - 1));
+            continue;
+        }
+        
+        if (IsInIgnoredDirectory(message_table, member.path))
+        {
+            LogDebug("ProcessTarFile, %s is in an ignored directory\n", display_path);
+            continue;
+        }
+        if (FindIgnoreExtensionIndex(message_table, member_name) != -1)
+        {
+            StringVector_PushBack(&message_table->skipped_files, member_name);
+            continue;
+        }
+        if (member.size == 0)
+        {
+            StringVector_PushBack(&message_table->empty_files, display_path);
+            continue;
+        }
+        
+        ScanState state;
+        BeginScan(message_table, &state, display_path, member.path);
+        while (!message_table->stop_requested && !state.hit_nul)
+        {
+            usize read = TarReadMember(&reader, (u8*)(chunk), sizeof(chunk));
+            if (read == 0) { break; }
+            StreamScan(message_table, &state, chunk, read);
+        }
+        EndStreamScan(message_table, &state);
+    }
+    
+    bool damaged = reader.error || (gzip && gzip->error);
+    if (damaged) { Log("Stopped reading %s, the archive is damaged or truncated\n", filename); }
+    if (member_count == 0 && !damaged) { StringVector_PushBack(&message_table->empty_files, filename); }
+    
+    if (gzip)
+    {
+        GzipClose(gzip);
+        TaggedFree(gzip);
+    }
+    else
+    {
+        FileClose(&file);
+    }
+}
+
+// --diff, what carries over between the lines of a unified diff
+// old_left and new_left count down the lines of the current hunk on each side, both are 0 outside a hunk
+typedef struct DiffScan
+{
+    ScanState state;
+    char path[MaxPath];
+    bool searching; // the file the hunks belong to passed the ignore rules
+    s32 next_line;  // line number in the new version of the file of the next context or added line
+    s32 old_left;
+    s32 new_left;
+} DiffScan;
+
+// git quotes a name with unusual bytes like a c string, "b/na\303\257ve.c" with each byte outside ascii as 3 octal digits
+static void UnquoteDiffPath(char* path, usize capacity, const char* start, const char* end)
+{
+    usize length = 0;
+    for (const char* c = start; c < end && length + 1 < capacity; c++)
+    {
+        char ch = *c;
+        if (ch == '\\' && c + 1 < end)
+        {
+            ch = *(++c);
+            if (ch >= '0' && ch <= '7')
+            {
+                u32 value = 0;
+                for (s32 digits = 0; digits < 3 && c < end && *c >= '0' && *c <= '7'; digits++, c++) { value = value * 8 + (u32)(*c - '0'); }
+                c--;
+                ch = (char)(value);
+            }
+            else if (ch == 'a') { ch = '\a'; }
+            else if (ch == 'b') { ch = '\b'; }
+            else if (ch == 't') { ch = '\t'; }
+            else if (ch == 'n') { ch = '\n'; }
+            else if (ch == 'v') { ch = '\v'; }
+            else if (ch == 'f') { ch = '\f'; }
+            else if (ch == 'r') { ch = '\r'; }
+        }
+        path[length++] = ch;
+    }
+    path[length] = '\0';
+}
+
+// "+++ b/src/file.c", diff -u puts a tab and a timestamp after the name and git quotes unusual ones
+static void BeginDiffFile(MessageTable* message_table, DiffScan* diff, const char* start, const char* end)
+{
+    const char* tab = (const char*)(memchr(start, '\t', end - start));
+    if (tab) { end = tab; }
+    bool quoted = (end - start >= 2 && start[0] == '"' && end[-1] == '"');
+    if (quoted) 
+    { 
+        start++; 
+        end--; 
+    }
+    if (end - start >= 2 && start[0] == 'b' && start[1] == '/') { start += 2; }
+    
+    diff->searching = false;
+    if (end - start == 9 && memcmp(start, "/dev/null", 9) == 0) { return; }
+    
+    if (quoted) { UnquoteDiffPath(diff->path, sizeof(diff->path), start, end); }
+    else
+    {
+        usize length = (usize)(end - start);
+        if (length >= sizeof(diff->path)) { length = sizeof(diff->path) - 1; }
+        memcpy(diff->path, start, length);
+        diff->path[length] = '\0';
+    }
+    
+    const char* filename = strrchr(diff->path, '/');
+    filename = filename ? filename + 1 : diff->path;
+    if (IsInIgnoredDirectory(message_table, diff->path))
+    {
+        LogDebug("ProcessUnifiedDiff, %s is in an ignored directory\n", diff->path);
+        return;
+    }
+    if (FindIgnoreExtensionIndex(message_table, filename) != -1)
+    {
+        StringVector_PushBack(&message_table->skipped_files, filename);
+        return;
+    }
+    
+    BeginScan(message_table, &diff->state, diff->path, diff->path);
+    diff->searching = true;
+}
+
+// "@@ -old_start,old_count +new_start,new_count @@", a missing count is 1
+static bool ParseHunkHeader(DiffScan* diff, const char* line, const char* end)
+{
+    s32 numbers[4] = { 0, 1, 0, 1 };
+    const char* c = line + 3;
+    for (s32 side = 0; side < 2; side++)
+    {
+        if (c >= end || *c != (side ? '+' : '-')) { return false; }
+        c++;
+        if (c >= end || !isdigit((u8)(*c))) { return false; }
+        
+        numbers[side * 2] = 0;
+        while (c < end && isdigit((u8)(*c))) { numbers[side * 2] = numbers[side * 2] * 10 + (*c++ - '0'); }
+        if (c < end && *c == ',')
+        {
+            c++;
+            numbers[side * 2 + 1] = 0;
+            while (c < end && isdigit((u8)(*c))) { numbers[side * 2 + 1] = numbers[side * 2 + 1] * 10 + (*c++ - '0'); }
+        }
+        while (c < end && *c == ' ') { c++; }
+    }
+    
+    diff->old_left = numbers[1];
+    diff->new_left = numbers[3];
+    diff->next_line = numbers[2];
+    return true;
+}
+
+// the lexer sees the new version of each hunk, context and added lines, so a match inside a block comment is still found
+// it starts over at every hunk since the lines between hunks aren't in the diff
+static void LexDiffLine(DiffScan* diff, const char* line_end)
+{
+    if (!diff->state.comments_only) { return; }
+    LeaveBuffer(&diff->state, line_end);
+    CommentLexer_Advance(&diff->state.lexer, "\n", "\n" + 1);
+}
+
+static void ProcessDiffLine(MessageTable* message_table, DiffScan* diff, const char* line, const char* line_end)
+{
+    if (line_end > line && line_end[-1] == '\r') { line_end--; }
+    
+    if (diff->old_left > 0 || diff->new_left > 0)
+    {
+        // some tools trim the space off an empty context line
+        char kind = (line < line_end) ? line[0] : ' ';
+        if (kind == '\\') { return; } // \ No newline at end of file
+        if (kind == '-')
+        {
+            diff->old_left--;
+            return;
+        }
+        if (kind == '+' || kind == ' ')
+        {
+            if (kind == ' ') { diff->old_left--; }
+            diff->new_left--;
+            
+            const char* text = (line < line_end) ? line + 1 : line_end;
+            if (diff->searching)
+            {
+                diff->state.lexed_to = text;
+                if (kind == '+')
+                {
+                    diff->state.line_number = diff->next_line;
+                    ProcessLineMatches(message_table, &diff->state, text, line_end);
+                }
+                LexDiffLine(diff, line_end);
+            }
+            diff->next_line++;
+            return;
+        }
+        
+        // anything else means the counts were off, treat it as the end of the hunk
+        diff->old_left = 0;
+        diff->new_left = 0;
+    }
+    
+    usize length = (usize)(line_end - line);
+    if (length >= 4 && memcmp(line, "+++ ", 4) == 0)
+    {
+        BeginDiffFile(message_table, diff, line + 4, line_end);
+    }
+    else if (length >= 5 && memcmp(line, "diff ", 5) == 0)
+    {
+        diff->searching = false;
+    }
+    else if (length >= 4 && memcmp(line, "@@ -", 4) == 0 && ParseHunkHeader(diff, line, line_end))
+    {
+        if (diff->searching && diff->state.comments_only) 
+        { 
+            CommentLexer_Init(&diff->state.lexer, GetCommentLanguage(diff->path)); 
+        }
+    }
+}
+
+// lines are handled in place in the read buffer, only a line split across two reads is copied
+// lines longer than MaxStreamLine are cut, memory is the same whatever the size of the diff
+void ProcessUnifiedDiff(MessageTable* message_table, File* file)
+{
+    DiffScan* diff = (DiffScan*)(TaggedCalloc(AllocationTag_FileContents, 1, sizeof(DiffScan)));
+    char* chunk = (char*)(TaggedMalloc(AllocationTag_FileContents, 16384));
+    char* carry = (char*)(TaggedMalloc(AllocationTag_FileContents, MaxStreamLine));
+    if (!diff || !chunk || !carry)
+    {
+        Log("--diff, out of memory\n");
+        message_table->scan_failed = true;
+        TaggedFree(diff);
+        TaggedFree(chunk);
+        TaggedFree(carry);
+        return;
+    }
+    
+    usize carry_size = 0;
+    while (!message_table->stop_requested)
+    {
+        MemoryBuffer buffer = { chunk, 16384 };
+        usize read = FileRead(&buffer, buffer.size, file);
+        if (read == 0) { break; }
+        
+        const char* current = chunk;
+        const char* end = chunk + read;
+        while (current < end && !message_table->stop_requested)
+        {
+            const char* newline = (const char*)(memchr(current, '\n', end - current));
+            const char* line_end = newline ? newline : end;
+            
+            if (carry_size > 0 || !newline)
+            {
+                usize room = MaxStreamLine - carry_size;
+                usize length = (usize)(line_end - current);
+                if (length > room) { length = room; }
+                memcpy(carry + carry_size, current, length);
+                carry_size += length;
+                if (!newline) { break; }
+                
+                ProcessDiffLine(message_table, diff, carry, carry + carry_size);
+                carry_size = 0;
+            }
+            else
+            {
+                ProcessDiffLine(message_table, diff, current, line_end);
+            }
+            current = newline + 1;
+        }
+    }
+    if (carry_size > 0 && !message_table->stop_requested) 
+    { 
+        ProcessDiffLine(message_table, diff, carry, carry + carry_size); 
+    }
+    
+    TaggedFree(diff);
+    TaggedFree(chunk);
+    TaggedFree(carry);
+}
+
+
+// files at least this big are split into chunks and scanned by a worker per core
+// under it the threads cost more than they save
+#define ParallelFileSize (64 * 1024 * 1024)
+#define MaxFileWorkers 16
+
+// one per chunk, the worker reads [read_start, read_end) and then scans the lines that start in [scan_start, scan_end)
+typedef struct FileWorker
+{
+    MessageTable* message_table;
+    const char* filename;
+    char* buffer;
+    u64 read_start;
+    u64 read_end;
+    usize read_room; // the last worker has room for one byte more, getting it means the file grew
+    usize read_size;
+    
+    const char* scan_start;
+    const char* scan_end;
+    s32 line_count;
+    bool hit_nul;
+    DeferredMatches deferred;
+    RegexScratch regex_scratch;
+    
+    Thread thread;
+} FileWorker;
+
+// every worker opens the file for itself, FileReadAt on windows moves the file position
+static void FileWorkerRead(void* data)
+{
+    FileWorker* worker = (FileWorker*)(data);
+    File file = {0};
+    if (!FileOpen(&file, worker->filename, "rb")) { return; }
+    worker->read_size = FileReadAt(&file, worker->read_start, worker->buffer + worker->read_start, worker->read_room);
+    FileClose(&file);
+}
+
+static void FileWorkerScan(void* data)
+{
+    FileWorker* worker = (FileWorker*)(data);
+    ScanState state;
+    BeginScan(worker->message_table, &state, worker->filename, worker->filename);
+    state.deferred = &worker->deferred;
+    state.regex_scratch = &worker->regex_scratch;
+    ScanLines(worker->message_table, &state, worker->scan_start, worker->scan_end, true);
+    worker->line_count = state.line_number - 1;
+    worker->hit_nul = state.hit_nul;
+}
+
+// runs function on every worker and waits for all of them, a worker that couldn't get a thread runs here instead
+static void RunFileWorkers(FileWorker* workers, usize worker_count, ThreadFunction function)
+{
+    for (usize i = 1; i < worker_count; i++) { Thread_Start(&workers[i].thread, function, &workers[i]); }
+    function(&workers[0]);
+    for (usize i = 1; i < worker_count; i++)
+    {
+        if (workers[i].thread.started) { Thread_Join(&workers[i].thread); }
+        else { function(&workers[i]); }
+    }
+}
+
+static void FreeFileWorkers(FileWorker* workers, usize worker_count, char* buffer)
+{
+    for (usize i = 0; workers && i < worker_count; i++)
+    {
+        TaggedFree(workers[i].deferred.matches);
+        RegexScratch_Free(&workers[i].regex_scratch);
+    }
+    TaggedFree(buffer);
+    TaggedFree(workers);
+}
+
+// the whole file is read by the workers in parallel, each into its own part of one buffer
+// chunk edges are moved forward to just past a \n so every line belongs to exactly one chunk
+// workers only match, the matches are recorded here afterwards in chunk order with the line numbers of the chunks before added on
+// that gives the table the same matches in the same order as ScanLines over the whole file would, max-results and fail-on stop at the same match
+// returns false when the file should go through the normal path instead
+static bool ProcessLargeFile(MessageTable* message_table, const char* filename, u64 size_hint)
+{
+    // the comment lexer carries its state from one line to the next, chunks can't start part way through
+    if (message_table->arguments.comments_only) { return false; }
+    
+    usize worker_count = GetProcessorCount();
+    if (worker_count > MaxFileWorkers) { worker_count = MaxFileWorkers; }
+    if (worker_count < 2 || size_hint > (u64)((usize)(-1) - 1)) { return false; }
+    
+    usize size = (usize)(size_hint);
+    char* buffer = (char*)(TaggedMalloc(AllocationTag_FileContents, size + 1));
+    FileWorker* workers = (FileWorker*)(TaggedCalloc(AllocationTag_FileContents, worker_count, sizeof(FileWorker)));
+    if (!buffer || !workers)
+    {
+        LogDebug("ProcessLargeFile, no memory for %s, scanning it in one piece\n", filename);
+        FreeFileWorkers(workers, worker_count, buffer);
+        return false;
+    }
+    
+    for (usize i = 0; i < worker_count; i++)
+    {
+        FileWorker* worker = &workers[i];
+        worker->message_table = message_table;
+        worker->filename = filename;
+        worker->buffer = buffer;
+        worker->read_start = (u64)(size) * i / worker_count;
+        worker->read_end = (u64)(size) * (i + 1) / worker_count;
+        worker->read_room = (usize)(worker->read_end - worker->read_start) + ((i + 1 == worker_count) ? 1 : 0);
+        if (message_table->regex_set.pattern_count > 0 && !RegexScratch_Init(&worker->regex_scratch, &message_table->regex_set))
+        {
+            LogDebug("ProcessLargeFile, no memory for regex scratch, scanning %s in one piece\n", filename);
+            FreeFileWorkers(workers, worker_count, buffer);
+            return false;
+        }
+    }
+    RunFileWorkers(workers, worker_count, FileWorkerRead);
+    
+    // a file that changed size since the walk saw it goes the normal way, the nul goes over the extra byte
+    bool ok = true;
+    for (usize i = 0; i < worker_count; i++)
+    {
+        if (workers[i].read_size != (usize)(workers[i].read_end - workers[i].read_start)) { ok = false; }
+    }
+    if (!ok)
+    {
+        LogDebug("ProcessLargeFile, %s changed while it was read, scanning it in one piece\n", filename);
+        FreeFileWorkers(workers, worker_count, buffer);
+        return false;
+    }
+    buffer[size] = '\0';
+    
+    usize bom_size = 0;
+    Utf16Order order = DetectUtf16((const u8*)(buffer), size, &bom_size);
+    if (order != Utf16Order_None)
+    {
+        ScanUtf16(message_table, filename, (const u8*)(buffer) + bom_size, size - bom_size, order);
+        FreeFileWorkers(workers, worker_count, buffer);
+        return true;
     }
-
-    // allocate each cell in the table
-    usize combination_count = message_table->symbols.size * message_table->keywords.size;
-    usize bytes_needed = combination_count * sizeof(MessageBucket);
-    message_table->message_buckets = (MessageBucket*)(malloc(bytes_needed));
     
-    if (!message_table->message_buckets)
+    // a line can't end part way through \r\n here, the edge is always after the \n
+    const char* end = buffer + size;
+    const char* edge = buffer;
+    for (usize i = 0; i < worker_count; i++)
     {
-        LogDebug("Failed to allocate message table text buffers");
-        return 0;
+        workers[i].scan_start = edge;
+        if (i + 1 == worker_count) { edge = end; }
+        else
+        {
+            const char* nominal = buffer + workers[i].read_end;
+            if (nominal < edge) { nominal = edge; }
+            const char* newline = (const char*)(memchr(nominal, '\n', end - nominal));
+            edge = newline ? newline + 1 : end;
+        }
+        workers[i].scan_end = edge;
     }
+    RunFileWorkers(workers, worker_count, FileWorkerScan);
     
-    memset(message_table->message_buckets, 0, combination_count * sizeof(MessageBucket));
+    ScanState state;
+    BeginScan(message_table, &state, filename, filename);
+    if (message_table->arguments.context_lines)
+    {
+        state.context_base = buffer;
+        state.context_file = -1;
+    }
     
-    // init the buckets
-    for (usize s = 0; s < message_table->symbols.size; s++)
+    s32 line_base = 0;
+    for (usize i = 0; i < worker_count; i++)
     {
-        for (usize k = 0; k < message_table->keywords.size; k++) 
+        FileWorker* worker = &workers[i];
+        for (usize m = 0; m < worker->deferred.count && !message_table->stop_requested; m++)
         {
-            usize type_index = s * message_table->keywords.size + k;
-            message_table->message_buckets[type_index].keyword = (s32)k;
-            message_table->message_buckets[type_index].symbol = (s32)s;
-            StringVector_Init(&message_table->message_buckets[type_index].strings);
+            DeferredMatch* match = &worker->deferred.matches[m];
+            state.line_number = line_base + match->line_number;
+            KeepMatch(message_table, &state, &match->results, match->line);
         }
+        // a nul ends the file, the chunks after it were never part of the scan
+        if (worker->hit_nul) { break; }
+        line_base += worker->line_count;
     }
-    return message_table;  
+    
+    LogDebug("ProcessLargeFile, %s scanned in %zu chunks\n", filename, worker_count);
+    FreeFileWorkers(workers, worker_count, buffer);
+    return true;
 }
 
-void FreeMessageTable(MessageTable* message_table)
+void ProcessFile(MessageTable* message_table, const char* filename, u64 size_hint) 
 {
-    if(message_table)
+    if (!IsInShard(message_table, filename)) { return; }
+    
+    if (IsTarPath(filename))
     {
-        if(message_table->message_buckets)
-        {
-            for (usize s = 0; s < message_table->symbols.size; s++)
-            {
-                for (usize k = 0; k < message_table->keywords.size; k++) 
-                {
-                    usize type_index = s * message_table->keywords.size + k;
-                    StringVector_Free(&message_table->message_buckets[type_index].strings);
-                }
-            }
-            free(message_table->message_buckets);
-        }
-        StringVector_Free(&message_table->symbols);
-        StringVector_Free(&message_table->keywords);
-        free(message_table);
+        ProcessTarFile(message_table, filename);
+        return;
+    }
+    if (StringEndsWith(filename, ".gz"))
+    {
+        ProcessGzipFile(message_table, filename);
+        return;
     }
     
-}
+    if (size_hint >= ParallelFileSize && ProcessLargeFile(message_table, filename, size_hint)) { return; }
+    
+    FileContents contents = {0};
+    usize size = GetFileContentsReusing(&contents, filename, size_hint, &message_table->read_buffer);
 
+    if (size == 0) 
+    {
+        LogDebug("File has no content, or failed to read content: %s\n", filename);
+        StringVector_PushBack(&message_table->empty_files, filename);
+        return;
+    }
 
-void ProcessUserRequest(MessageTable* message_table, s32 argc, char** argv)
-{
-    if(!message_table) 
-    { 
-        Log("null message_table for user request. did you call AllocateMessageTable(user_config)?"); 
-        Exit(-1); 
+    // windows tools like to write .rc, .cs and generated headers as utf-16, every other byte would be a nul
+    usize bom_size = 0;
+    Utf16Order order = DetectUtf16((const u8*)(contents.memory.buffer), size, &bom_size);
+    if (order != Utf16Order_None)
+    {
+        ScanUtf16(message_table, filename, (const u8*)(contents.memory.buffer) + bom_size, size - bom_size, order);
+        FreeFileContents(&contents);
+        return;
     }
 
-    // @todo:: actually handle the user arguments
-    const char* directory = ".";
-    ProcessDirectory(message_table, directory);
+    ScanState state;
+    BeginScan(message_table, &state, filename, filename);
+    if (message_table->arguments.context_lines)
+    {
+        state.context_base = contents.memory.buffer;
+        state.context_file = -1;
+    }
+    ScanLines(message_table, &state, contents.memory.buffer, contents.memory.buffer + size, true);
+
+    FreeFileContents(&contents);
 }
 
-// returns -1 if the file's extension is not in the extension list in the table
-static s32 FindIgnoreExtensionIndex(MessageTable* message_table, const char* file)
+
+// reserves a node in traversal order so the tree prints top down
+// the counts are filled in once the directory is done
+static s64 AddRollupNode(MessageTable* message_table, const char* directory)
 {
-    if(!message_table || !file) { return false; }
-    for(s32 i = 0; i < message_table->ignore_extensions.size; ++i)
+    if (message_table->rollup_node_count >= message_table->rollup_node_capacity)
     {
-        const char* extension = message_table->ignore_extensions.data[i];
-        if(StringEndsWith(file, extension))
+        usize new_capacity = message_table->rollup_node_capacity ? message_table->rollup_node_capacity * 2 : 64;
+        RollupNode* new_nodes = (RollupNode*)(TaggedRealloc(AllocationTag_MessageTable, message_table->rollup_nodes, new_capacity * sizeof(RollupNode)));
+        if (!new_nodes)
         {
-            return i;
+            LogDebug("AddRollupNode, failed to grow rollup nodes\n");
+            return -1;
         }
+        message_table->rollup_nodes = new_nodes;
+        message_table->rollup_node_capacity = new_capacity;
     }
-    return -1;
+    
+    usize length = StringLength(directory);
+    RollupNode* node = &message_table->rollup_nodes[message_table->rollup_node_count];
+    memset(node, 0, sizeof(RollupNode));
+    node->path = (char*)(TaggedMalloc(AllocationTag_MessageTable, length + 1));
+    if (!node->path) { return -1; }
+    StringCopy_NullTerminate(node->path, directory, length + 1);
+    node->depth = message_table->rollup_current_depth;
+    return (s64)(message_table->rollup_node_count++);
 }
 
-static s32 FindIgnoreDirectoryIndex(MessageTable* message_table, const char* directory)
+// called as ProcessDirectory unwinds, pushes this directory's counts into its parent
+static void FinishRollup(MessageTable* message_table, usize* counts, usize* parent_counts, s64 node_index)
 {
-    if(!message_table || !directory) { return -1; }
-    for(s32 i = 0; i < message_table->ignore_directories.size; ++i)
+    usize bucket_count = message_table->bucket_count;
+    usize total = 0;
+    for (usize i = 0; i < bucket_count; i++)
     {
-        if(StringCompare(directory, message_table->ignore_directories.data[i]) == 0)
-        {
-            return i;
-        }
+        total += counts[i];
+        if (parent_counts) { parent_counts[i] += counts[i]; }
+    }
+    
+    if (node_index >= 0)
+    {
+        message_table->rollup_nodes[node_index].counts = counts;
+        message_table->rollup_nodes[node_index].total = total;
+    }
+    else
+    {
+        TaggedFree(counts);
     }
-    return -1;
 }
 
-typedef struct ProcessLineResults
+// one directory on the walk stack, its entries were read and its handle closed when it was pushed
+// so a deep tree holds one open directory at most, and the stack is heap memory instead of two MaxPath buffers a level
+typedef struct WalkFrame
 {
-    s32 symbol_index;
-    s32 keyword_index;
-    const char* at_pos;
-}ProcessLineResults;
+    DirectoryListing listing; // kept when the frame is popped, the next directory at this depth reuses it
+    usize next_entry;
+    usize path_length;        // where this directory ends in the shared path
+    FileBatch batch;          // --inode-order
+    usize* counts;            // --rollup-depth, this directory's and what they are added to when it's done
+    usize* parent_counts;
+    s64 rollup_node;
+} WalkFrame;
 
-ProcessLineResults ProcessLine(MessageTable* message_table, const char* line)
+typedef struct Walk
 {
-    ProcessLineResults results;
-    results.symbol_index = -1;
-    results.keyword_index = -1;
-    results.at_pos = 0;
-    if(!message_table) { return results; }
- 
-    for (usize s = 0; s < message_table->symbols.size; s++) 
+    WalkFrame* frames;
+    usize depth;
+    usize capacity;
+    char* path; // MaxPath, every entry's path is the directory's plus the name written in place
+} Walk;
+
+#ifdef OS_Win32
+    #define PathSeparator '\\'
+#else
+    #define PathSeparator '/'
+#endif
+
+static bool PushWalkFrame(MessageTable* message_table, Walk* walk, usize path_length)
+{
+    if (walk->depth >= walk->capacity)
     {
-        for (usize k = 0; k < message_table->keywords.size; k++) 
+        usize new_capacity = walk->capacity ? walk->capacity * 2 : 16;
+        WalkFrame* new_frames = (WalkFrame*)(TaggedRealloc(AllocationTag_MessageTable, walk->frames, new_capacity * sizeof(WalkFrame)));
+        if (!new_frames)
         {
-            // looking for keyword+pattern, like @todo
-            char pattern[64];
-            snprintf(pattern, sizeof(pattern), "%s%s", message_table->symbols.data[s], message_table->keywords.data[k]);
-            char* found = strstr(line, pattern); // @todo:: write myself, find needle in haystack
-            if (found) 
-            {
-                usize pattern_length = StringLength(pattern);
-                char next_char = found[pattern_length];
-                bool is_alnum = isalpha(next_char) || isdigit(next_char);
-                if (!is_alnum && next_char != '_') 
-                {
-                    results.symbol_index = (s32)s;
-                    results.keyword_index = (s32)k;
-                    results.at_pos = found;
-                    return results;
-                }
-            }
+            Log("Failed to grow the directory stack at %s\n", walk->path);
+            message_table->scan_failed = true;
+            message_table->stop_requested = true;
+            return false;
         }
+        memset(new_frames + walk->capacity, 0, (new_capacity - walk->capacity) * sizeof(WalkFrame));
+        walk->frames = new_frames;
+        walk->capacity = new_capacity;
     }
-    return results;
-}
-
-void ProcessFile(MessageTable* message_table, const char* filename) 
-{
-    FileContents contents = {0};
-    usize size = GetFileContents(&contents, filename);
-
-    if (size == 0) 
+    
+    WalkFrame* frame = &walk->frames[walk->depth];
+    if (!DirectoryList(&frame->listing, walk->path, path_length)) 
     {
-        LogDebug("File has no content, or failed to read content: %s\n", filename);
-        StringVector_PushBack(&message_table->empty_files, filename);
-        return;
+        Log("Failed to open directory: %s\n", walk->path);
+        message_table->scan_failed = true;
+        message_table->stop_requested = true;
+        return false;
     }
-
-    const char* current = contents.memory.buffer;
-    s32 line_number = 1;
+    frame->next_entry = 0;
+    frame->path_length = path_length;
+    memset(&frame->batch, 0, sizeof(FileBatch));
     
-    while (current && *current != '\0') 
+    frame->parent_counts = message_table->rollup_counts;
+    frame->counts = 0;
+    frame->rollup_node = -1;
+    if (message_table->arguments.rollup)
     {
-        // handle line endings
-        const char* line_end = current;
-        while (*line_end && *line_end != '\n' && *line_end != '\r') { line_end++; }
-        
-        if (line_end > current) 
+        frame->counts = (usize*)(TaggedCalloc(AllocationTag_MessageTable, message_table->bucket_count, sizeof(usize)));
+        if (frame->counts && message_table->rollup_current_depth <= message_table->arguments.rollup_depth)
         {
-            char line[1024];
-            usize line_len = line_end - current;
-            if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
-            memcpy(line, current, line_len);
-            line[line_len] = '\0';
-            
-            ProcessLineResults results = ProcessLine(message_table, line);
-            if (results.at_pos) 
-            {
-                // Prepare output
-                char buffer[1024];
-                usize length = StringLength(filename);
-                snprintf(buffer, sizeof(buffer), "%-48.*s %4d: %s\n", (s32)(length), filename, line_number, results.at_pos);
-                usize type_index = results.symbol_index * message_table->keywords.size + results.keyword_index;
-                StringVector_PushBack(&message_table->message_buckets[type_index].strings, buffer);
-            }
+            frame->rollup_node = AddRollupNode(message_table, walk->path);
         }
-        
-        current = line_end;
-        if (*current == '\r') current++;
-        if (*current == '\n') current++;
-        line_number++;
+        message_table->rollup_counts = frame->counts;
     }
-
-    FreeFileContents(&contents);
+    message_table->rollup_current_depth++;
+    walk->depth++;
+    return true;
 }
 
+// everything under the directory has been walked, its batched files are searched and its counts go to its parent
+static void PopWalkFrame(MessageTable* message_table, Walk* walk)
+{
+    WalkFrame* frame = &walk->frames[--walk->depth];
+    ProcessFileBatch(message_table, &frame->batch);
+    
+    message_table->rollup_current_depth--;
+    if (frame->counts)
+    {
+        FinishRollup(message_table, frame->counts, frame->parent_counts, frame->rollup_node);
+    }
+    message_table->rollup_counts = frame->parent_counts;
+}
 
+// depth first in the order the directories list their entries, a subdirectory is walked where it shows up
 void ProcessDirectory(MessageTable* message_table, const char* directory) 
 {
-    DirectoryIterator directory_iterator = {0};
-    DirectoryEntry current_entry = {0};
-    
-    if (!DirectoryOpen(&directory_iterator, directory)) 
+    Walk walk = {0};
+    walk.path = (char*)(TaggedMalloc(AllocationTag_MessageTable, MaxPath));
+    if (!walk.path)
     {
-        Log("Failed to open directory: %s\n", directory);
-        Exit(-1);
+        Log("Failed to allocate the walk for %s\n", directory);
+        message_table->scan_failed = true;
+        message_table->stop_requested = true;
+        return;
     }
+    usize root_length = StringCopy_NullTerminate(walk.path, directory, MaxPath);
+    PushWalkFrame(message_table, &walk, root_length);
     
-    while (DirectoryNextEntry(&directory_iterator, &current_entry)) 
+    while (walk.depth > 0) 
     {
-        const char* filename = current_entry.name;
-        if(!filename) 
+        WalkFrame* frame = &walk.frames[walk.depth - 1];
+        if (message_table->stop_requested || frame->next_entry >= frame->listing.count)
+        {
+            PopWalkFrame(message_table, &walk);
+            continue;
+        }
+        if (DeadlinePassed(message_table))
         {
-            LogDebug("ProcessDirectory, directory iterator got null file, skipping");
+            message_table->deadline_walk_incomplete = true;
+            PopWalkFrame(message_table, &walk);
             continue;
         }
         
+        DirectoryListingEntry* entry = &frame->listing.entries[frame->next_entry++];
+        const char* filename = frame->listing.names + entry->name_offset;
+        if (StringCompare(filename, log_file_name) == 0) { continue; }
         
-        if (StringCompare(filename, ".") == 0 || 
-            StringCompare(filename, "..") == 0 ||
-            StringCompare(filename, log_file_name) == 0)
+        // directory/file, or /file under the root
+        usize path_length = frame->path_length;
+        if (path_length + entry->name_length + 2 > MaxPath)
         {
+            LogDebug("ProcessDirectory, huge file paths being combined, skipping the rest of the directory\n    %.*s\n    /%s\n", (s32)(path_length), walk.path, filename);
+            frame->next_entry = frame->listing.count;
             continue;
         }
-
-
-        if (current_entry.type == FileType_Directory) 
+        walk.path[path_length] = PathSeparator;
+        memcpy(walk.path + path_length + 1, filename, entry->name_length + 1);
+        usize entry_path_length = path_length + 1 + entry->name_length;
+        
+        if (entry->type == FileType_Directory) 
         {
             s32 directory_ignore_index = FindIgnoreDirectoryIndex(message_table, filename);
-            if(directory_ignore_index == -1)
-            {        
-                ProcessDirectory(message_table, current_entry.path);
-            }
-            else
+            if(directory_ignore_index != -1)
             {
                 StringVector_PushBack(&message_table->skipped_directories, filename);
             }
-            
+            else if(message_table->arguments.one_file_system && entry->device != message_table->root_device)
+            {
+                LogDebug("ProcessDirectory, %s is on another file system, skipping\n", walk.path);
+                message_table->other_file_system_count++;
+            }
+            else if(MarkVisited(message_table, walk.path, entry->type, entry->device, entry->inode, entry->link_count))
+            {        
+                // frame and entry can move when the stack grows, nothing below touches them
+                PushWalkFrame(message_table, &walk, entry_path_length);
+            }
         } 
-        else if (current_entry.type == FileType_File) 
+        else if (entry->type == FileType_File) 
         {
             s32 ignore_extension_index = FindIgnoreExtensionIndex(message_table, filename);
             if(ignore_extension_index == -1)
             {        
-                ProcessFile(message_table, current_entry.path);
+                if(!MarkVisited(message_table, walk.path, entry->type, entry->device, entry->inode, entry->link_count)) { continue; }
+                
+                if(message_table->arguments.deadline_ms) 
+                { 
+                    FileBatch_Add(&message_table->deadline_files, walk.path, entry->inode, entry->modified_time, entry->size); 
+                }
+                else if(message_table->arguments.inode_order) 
+                { 
+                    FileBatch_Add(&frame->batch, walk.path, entry->inode, entry->modified_time, entry->size); 
+                }
+                else { ProcessFile(message_table, walk.path, entry->size); }
             }
-            else
+            else if(IsInShard(message_table, walk.path))
             {
+                // every shard walks every directory, only the one that would have searched the file counts it
                 StringVector_PushBack(&message_table->skipped_files, filename);
             }
         }
     }
     
-    DirectoryClose(&directory_iterator);
+    for (usize i = 0; i < walk.capacity; i++) { DirectoryListing_Free(&walk.frames[i].listing); }
+    TaggedFree(walk.frames);
+    TaggedFree(walk.path);
 }
 
 //=====================================================================================================================
 // Output
 //=====================================================================================================================
+// [symbol][keyword] or the regex pattern text
+void GetBucketName(MessageTable* message_table, usize bucket_index, char* name, usize name_size)
+{
+    s32 symbol = -1;
+    s32 keyword = -1;
+    GetBucketCombination(message_table, bucket_index, &symbol, &keyword);
+    if (symbol < 0)
+    {
+        StringCopy_NullTerminate(name, message_table->regex_patterns.data[keyword], name_size);
+    }
+    else
+    {
+        snprintf(name, name_size, "%s%s", message_table->symbols.data[symbol], message_table->keywords.data[keyword]);
+    }
+}
+
 void PrintSearchPatterns(MessageTable* message_table)
 {   
-    // @todo:: actually print out the combinations not just my basic @ combos
+    if (message_table->large_vocabulary)
+    {
+        Log
+        (
+            "Finding all instances of [symbol][keyword], %zu symbols and %zu keywords (%zu combinations)\n\n", 
+            message_table->symbols.size, message_table->keywords.size, message_table->pattern_count
+        );
+        for(usize p = 0; p < message_table->regex_patterns.size; ++p)
+        {
+            Log("    %s  (pattern)\n", message_table->regex_patterns.data[p]);
+        }
+        if (message_table->regex_patterns.size) { Log("\n"); }
+        return;
+    }
+    
     Log("Finding all instances of [symbol][keyword]:\n\n");
-    for(usize i = 0; i < message_table->keywords.size; ++i)
+    for(usize s = 0; s < message_table->symbols.size; ++s)
+    {
+        for(usize k = 0; k < message_table->keywords.size; ++k)
+        {
+            bool case_insensitive = message_table->keyword_case_insensitive && message_table->keyword_case_insensitive[k];
+            Log("    %s%s%s\n", message_table->symbols.data[s], message_table->keywords.data[k], case_insensitive ? "  (any case)" : "");
+        }
+    }
+    for(usize p = 0; p < message_table->regex_patterns.size; ++p)
     {
-        Log("    @%s\n", message_table->keywords.data[i]);
+        Log("    %s  (pattern)\n", message_table->regex_patterns.data[p]);
     }
     Log("\n");
 }
@@ -348,12 +2291,20 @@ void PrintIgnoredDirectories(MessageTable* message_table)
     {
         Log("    %s\n", message_table->skipped_directories.data[i]);
     }
+    if(message_table->other_file_system_count)
+    {
+        Log("    %zu on other file systems (--one-file-system)\n", message_table->other_file_system_count);
+    }
+    if(message_table->deduplicated_count)
+    {
+        Log("    %zu files and directories already searched through another link (symlinks, hard links, loops)\n", message_table->deduplicated_count);
+    }
     Log("\n");
 }
 void PrintIgnoredFiles(MessageTable* message_table)
 {
     s32 extension_count = message_table->ignore_extensions.size;
-    s32* counts = malloc(extension_count * sizeof(s32));
+    s32* counts = TaggedMalloc(AllocationTag_MessageTable, extension_count * sizeof(s32));
     if(!counts) { return; }
     
     for(s32 i = 0; i < extension_count; ++i)
@@ -380,7 +2331,7 @@ void PrintIgnoredFiles(MessageTable* message_table)
     }
     Log("\n");
     
-    free(counts);
+    TaggedFree(counts);
 }
 void PrintEmptyFiles(MessageTable* message_table)
 {
@@ -391,45 +2342,279 @@ void PrintEmptyFiles(MessageTable* message_table)
     }
     Log("\n");
 }
+// longest context line shown, and how far either side of a match we read looking for line breaks
+#define MaxContextLineLength 256
+#define MaxContextWindow (64 * 1024)
+
+typedef struct ContextText
+{
+    char* data;
+    usize size;
+    usize capacity;
+} ContextText;
+
+static void ContextText_Write(ContextText* text, const char* data, usize length)
+{
+    if (text->size + length + 1 > text->capacity)
+    {
+        usize new_capacity = text->capacity ? text->capacity * 2 : 1024;
+        while (new_capacity < text->size + length + 1) { new_capacity *= 2; }
+        char* new_data = (char*)(TaggedRealloc(AllocationTag_StringVector, text->data, new_capacity));
+        if (!new_data) { return; }
+        text->data = new_data;
+        text->capacity = new_capacity;
+    }
+    memcpy(text->data + text->size, data, length);
+    text->size += length;
+    text->data[text->size] = '\0';
+}
+
+static void AppendContextLine(ContextText* text, s32 line_number, const char* line, const char* line_end)
+{
+    s32 length = (s32)(line_end - line);
+    if (length > MaxContextLineLength) { length = MaxContextLineLength; }
+    
+    char buffer[MaxContextLineLength + 128];
+    s32 used = snprintf(buffer, sizeof(buffer), "    %-48s %4d- %.*s\n", "", line_number, length, line);
+    if (used > 0) { ContextText_Write(text, buffer, (used < (s32)(sizeof(buffer))) ? (usize)(used) : sizeof(buffer) - 1); }
+}
+
+// lines end the same way ScanLines ends them, \r\n, \n or a \r on its own, so the numbers agree
+static const char* FindContextLineEnd(const char* line, const char* end)
+{
+    while (line < end && *line && *line != '\n' && *line != '\r') { line++; }
+    return line;
+}
+
+// reads the lines around one match and appends them under its message
+static void AppendContext(ContextText* text, File* file, MatchLocation* location, usize context_lines, char* window, usize window_size)
+{
+    // before, walk back from the start of the matched line
+    u64 before_start = (location->line_offset > window_size) ? location->line_offset - window_size : 0;
+    usize before_size = FileReadAt(file, before_start, window, (usize)(location->line_offset - before_start));
+    
+    const char* lines[64];
+    const char* line_ends[64];
+    usize line_count = 0;
+    const char* cursor = window + before_size;
+    while (line_count < context_lines && cursor > window)
+    {
+        // cursor sits just after the line ending of the line before it
+        const char* line_end = cursor;
+        if (line_end[-1] == '\n')
+        {
+            line_end--;
+            if (line_end > window && line_end[-1] == '\r') { line_end--; }
+        }
+        else if (line_end[-1] == '\r') { line_end--; }
+        
+        const char* line_start = line_end;
+        while (line_start > window && line_start[-1] != '\n' && line_start[-1] != '\r') { line_start--; }
+        if (line_start == window && before_start > 0) { break; } // cut off by the window, don't show half a line
+        lines[line_count] = line_start;
+        line_ends[line_count] = line_end;
+        line_count++;
+        cursor = line_start;
+    }
+    for (usize i = line_count; i > 0; i--)
+    {
+        AppendContextLine(text, location->line_number - (s32)(i), lines[i - 1], line_ends[i - 1]);
+    }
+    
+    // after, skip the matched line then take the next ones
+    usize after_size = FileReadAt(file, location->line_offset, window, window_size);
+    const char* end = window + after_size;
+    const char* line_end = FindContextLineEnd(window, end);
+    for (usize i = 1; i <= context_lines; i++)
+    {
+        // a nul ended the search there
+        if (line_end >= end || *line_end == '\0') { break; }
+        const char* line = line_end + 1;
+        if (*line_end == '\r')
+        {
+            // a \r at the end of the window might be the first half of \r\n
+            if (line >= end) { break; }
+            if (*line == '\n') { line++; }
+        }
+        if (line >= end) { break; }
+        
+        line_end = FindContextLineEnd(line, end);
+        if (line_end < end && *line_end == '\0') { break; }
+        AppendContextLine(text, location->line_number + (s32)(i), line, line_end);
+    }
+}
+
+// -C, runs before the buckets are sorted while message indices still line up with match_locations
+// locations are grouped by file with a counting sort so each file is opened once and only the ranges around matches are read
+void AttachContextLines(MessageTable* message_table)
+{
+    usize location_count = message_table->match_location_count;
+    usize file_count = message_table->context_files.size;
+    if (!location_count || !file_count) { return; }
+    
+    usize context_lines = message_table->arguments.context_lines;
+    if (context_lines > 64) { context_lines = 64; }
+    usize window_size = context_lines * 4096;
+    if (window_size > MaxContextWindow) { window_size = MaxContextWindow; }
+    
+    usize* file_starts = (usize*)(TaggedCalloc(AllocationTag_MessageTable, file_count + 1, sizeof(usize)));
+    usize* order = (usize*)(TaggedMalloc(AllocationTag_MessageTable, location_count * sizeof(usize)));
+    char* window = (char*)(TaggedMalloc(AllocationTag_FileContents, window_size));
+    if (!file_starts || !order || !window)
+    {
+        TaggedFree(file_starts);
+        TaggedFree(order);
+        TaggedFree(window);
+        return;
+    }
+    
+    for (usize i = 0; i < location_count; i++) { file_starts[message_table->match_locations[i].file + 1]++; }
+    for (usize f = 0; f < file_count; f++) { file_starts[f + 1] += file_starts[f]; }
+    for (usize i = 0; i < location_count; i++) 
+    { 
+        order[file_starts[message_table->match_locations[i].file]++] = i; 
+    }
+    // file_starts now holds each file's end, which is the next file's start
+    
+    usize start = 0;
+    for (usize f = 0; f < file_count; f++)
+    {
+        usize end = file_starts[f];
+        File file = {0};
+        if (start < end && FileOpen(&file, message_table->context_files.data[f], "rb"))
+        {
+            for (usize i = start; i < end; i++)
+            {
+                MatchLocation* location = &message_table->match_locations[order[i]];
+                StringVector* strings = &FindBucket(message_table, location->bucket)->strings;
+                
+                ContextText text = {0};
+                ContextText_Write(&text, strings->data[location->message], StringLength(strings->data[location->message]));
+                AppendContext(&text, &file, location, context_lines, window, window_size);
+                if (text.data)
+                {
+                    TaggedFree(strings->data[location->message]);
+                    strings->data[location->message] = text.data;
+                }
+            }
+            FileClose(&file);
+        }
+        start = end;
+    }
+    
+    TaggedFree(file_starts);
+    TaggedFree(order);
+    TaggedFree(window);
+    
+    // the messages have their context now, a second call must not add it again
+    message_table->match_location_count = 0;
+}
+
 void PrintMessages(MessageTable* message_table)
 {
-    for (usize s = 0; s < message_table->symbols.size; s++) 
+    AttachContextLines(message_table);
+    
+    if (message_table->deadline_reached)
     {
-        for (usize k = 0; k < message_table->keywords.size; k++) 
+        Log
+        (
+            "Stopped at the %llu ms deadline, %zu files were not searched%s\n\n", 
+            (unsigned long long)(message_table->arguments.deadline_ms), 
+            message_table->deadline_unsearched_count,
+            message_table->deadline_walk_incomplete ? " and some directories were not read" : ""
+        );
+    }
+    else if (message_table->stop_requested)
+    {
+        if (message_table->fail_on_keyword_index >= 0 && message_table->exit_code != 0)
+        {
+            Log("Stopped at the first match of \"%s\"\n\n", message_table->arguments.fail_on_keyword);
+        }
+        else
+        {
+            Log("Stopped after %zu results\n\n", message_table->match_count);
+        }
+    }
+    
+    // a large vocabulary only prints what was hit, otherwise every combination is listed
+    SortBuckets(message_table);
+    usize print_count = message_table->large_vocabulary ? message_table->message_bucket_count : message_table->bucket_count;
+    for (usize b = 0; b < print_count; b++) 
+    {
+        MessageBucket* bucket = message_table->large_vocabulary ? &message_table->message_buckets[b] : FindBucket(message_table, b);
+        char name[128];
+        GetBucketName(message_table, bucket ? bucket->index : b, name, sizeof(name));
+        
+        if (!bucket || bucket->count == 0) 
+        {
+            Log("[%s]: (no messages)\n", name);
+        }
+        else if (bucket->strings.size == 0)
+        {
+            Log
+            (
+                "[%s]: (%zu %s)\n", 
+                name, 
+                bucket->count,
+                (bucket->count > 1) ? "messages" : "message"
+            );
+        }
+        else
         {
-            usize type_index = s * message_table->keywords.size + k;
-            if (message_table->message_buckets[type_index].strings.size == 0) 
+            StringVector_Sort(&bucket->strings);
+            
+            Log
+            (
+                "[%s]: (%d %s)\n\n", 
+                name, 
+                bucket->strings.size,
+                (bucket->strings.size > 1) ? "messages" : "message"
+            );
+            
+            for (usize i = 0; i < bucket->strings.size; i++) 
             {
                 Log
                 (
-                    "[%s%s]: (no messages)\n", 
-                    message_table->symbols.data[s], 
-                    message_table->keywords.data[k]
+                    "    %s", 
+                    bucket->strings.data[i]
                 );
             }
-            else
+            Log("\n\n");
+        }
+    }
+}
+
+void PrintRollup(MessageTable* message_table)
+{
+    if (!message_table->arguments.rollup) { return; }
+    
+    Log("\nRollup (matches per directory, %zu %s deep):\n\n", message_table->arguments.rollup_depth, (message_table->arguments.rollup_depth == 1) ? "level" : "levels");
+    for (usize i = 0; i < message_table->rollup_node_count; i++)
+    {
+        RollupNode* node = &message_table->rollup_nodes[i];
+        if (!node->counts || (node->total == 0 && node->depth > 0)) { continue; }
+        
+        // children only show their own name, the indent shows where they live
+        const char* name = node->path;
+        if (node->depth > 0)
+        {
+            const char* slash = strrchr(node->path, '/');
+            const char* backslash = strrchr(node->path, '\\');
+            if (backslash > slash) { slash = backslash; }
+            if (slash) { name = slash + 1; }
+        }
+        
+        Log("    %6zu  %*s%s", node->total, (s32)(node->depth * 2), "", name);
+        for (usize b = 0; b < message_table->bucket_count; b++) 
+        {
+            if (node->counts[b] > 0)
             {
-                StringVector_Sort(&message_table->message_buckets[type_index].strings);
-                
-                Log
-                (
-                    "[%s%s]: (%d %s)\n\n", 
-                    message_table->symbols.data[s], 
-                    message_table->keywords.data[k], 
-                    message_table->message_buckets[type_index].strings.size,
-                    (message_table->message_buckets[type_index].strings.size > 1) ? "messages" : "message"
-                );
-                
-                for (usize i = 0; i < message_table->message_buckets[type_index].strings.size; i++) 
-                {
-                    Log
-                    (
-                        "    %s", 
-                        message_table->message_buckets[type_index].strings.data[i]
-                    );
-                }
-                Log("\n\n");
+                char bucket_name[128];
+                GetBucketName(message_table, b, bucket_name, sizeof(bucket_name));
+                Log("  %s (%zu)", bucket_name, node->counts[b]);
             }
         }
+        Log("\n");
     }
-}
\ No newline at end of file
+    Log("\n");
+}
@@ -0,0 +1,409 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// --emit-partial and --merge
+// a partial file is one shard's buckets with their messages already sorted, so merging is a k-way merge per bucket
+// numbers are little endian whatever machine wrote them
+//
+// only buckets that were hit are written, in bucket index order
+// the ignored directories, ignored files and empty files lists come before them so the merged report has them too
+//
+//     "TDFP" u32 version u32 bucket_count u64 match_count
+//     ignored directories, ignored files, empty files, each as u32 count + strings as u32 length + bytes
+//     u32 written_bucket_count
+//     per written bucket: u32 bucket_index, u16 name_length, name, u64 count, u64 message_count, messages as u32 length + bytes
+
+#define PartialMagic "TDFP"
+#define PartialVersion 3
+
+typedef struct PartialWriter
+{
+    u8* data;
+    usize size;
+    usize capacity;
+    bool failed;
+} PartialWriter;
+
+static void PutBytes(PartialWriter* writer, const void* bytes, usize count)
+{
+    if (writer->failed) { return; }
+    if (writer->size + count > writer->capacity)
+    {
+        usize new_capacity = writer->capacity ? writer->capacity * 2 : 64 * 1024;
+        while (new_capacity < writer->size + count) { new_capacity *= 2; }
+        u8* new_data = (u8*)(realloc(writer->data, new_capacity));
+        if (!new_data) 
+        { 
+            writer->failed = true; 
+            return; 
+        }
+        writer->data = new_data;
+        writer->capacity = new_capacity;
+    }
+    memcpy(writer->data + writer->size, bytes, count);
+    writer->size += count;
+}
+
+static void PutNumber(PartialWriter* writer, u64 value, usize byte_count)
+{
+    u8 bytes[8];
+    for (usize i = 0; i < byte_count; i++) { bytes[i] = (u8)(value >> (i * 8)); }
+    PutBytes(writer, bytes, byte_count);
+}
+
+typedef struct PartialReader
+{
+    const u8* at;
+    const u8* end;
+    bool failed;
+} PartialReader;
+
+static u64 GetNumber(PartialReader* reader, usize byte_count)
+{
+    if (reader->failed || (usize)(reader->end - reader->at) < byte_count) 
+    { 
+        reader->failed = true; 
+        return 0; 
+    }
+    u64 value = 0;
+    for (usize i = 0; i < byte_count; i++) { value |= (u64)(reader->at[i]) << (i * 8); }
+    reader->at += byte_count;
+    return value;
+}
+
+static const char* GetBytes(PartialReader* reader, usize count)
+{
+    if (reader->failed || (usize)(reader->end - reader->at) < count) 
+    { 
+        reader->failed = true; 
+        return 0; 
+    }
+    const char* bytes = (const char*)(reader->at);
+    reader->at += count;
+    return bytes;
+}
+
+static void PutStrings(PartialWriter* writer, StringVector* strings)
+{
+    PutNumber(writer, strings->size, 4);
+    for (usize i = 0; i < strings->size; i++)
+    {
+        usize length = StringLength(strings->data[i]);
+        PutNumber(writer, length, 4);
+        PutBytes(writer, strings->data[i], length);
+    }
+}
+
+bool WritePartialResults(MessageTable* message_table, const char* path)
+{
+    // context lines have to be read here, the merging machine may not have the files
+    AttachContextLines(message_table);
+    
+    PartialWriter writer = {0};
+    PutBytes(&writer, PartialMagic, 4);
+    PutNumber(&writer, PartialVersion, 4);
+    PutNumber(&writer, message_table->bucket_count, 4);
+    PutNumber(&writer, message_table->match_count, 8);
+    PutStrings(&writer, &message_table->skipped_directories);
+    PutStrings(&writer, &message_table->skipped_files);
+    PutStrings(&writer, &message_table->empty_files);
+    PutNumber(&writer, message_table->message_bucket_count, 4);
+    
+    SortBuckets(message_table);
+    for (usize b = 0; b < message_table->message_bucket_count; b++)
+    {
+        MessageBucket* bucket = &message_table->message_buckets[b];
+        StringVector_Sort(&bucket->strings);
+        
+        char name[128];
+        GetBucketName(message_table, bucket->index, name, sizeof(name));
+        usize name_length = StringLength(name);
+        PutNumber(&writer, bucket->index, 4);
+        PutNumber(&writer, name_length, 2);
+        PutBytes(&writer, name, name_length);
+        PutNumber(&writer, bucket->count, 8);
+        PutNumber(&writer, bucket->strings.size, 8);
+        for (usize i = 0; i < bucket->strings.size; i++)
+        {
+            usize length = StringLength(bucket->strings.data[i]);
+            PutNumber(&writer, length, 4);
+            PutBytes(&writer, bucket->strings.data[i], length);
+        }
+    }
+    
+    bool written = false;
+    File file = {0};
+    if (!writer.failed && FileOpen(&file, path, "wb"))
+    {
+        MemoryBuffer buffer = { (char*)(writer.data), writer.size };
+        written = FileWrite(&buffer, writer.size, &file) == writer.size;
+        FileClose(&file);
+    }
+    if (!written) { Log("Failed to write partial results to %s\n", path); }
+    
+    free(writer.data);
+    return written;
+}
+
+// one partial file's place in the bucket currently being merged
+// next_bucket is the index of the bucket it has up next, bucket_count once it has none left
+typedef struct MergeCursor
+{
+    PartialReader reader;
+    u64 buckets_left;
+    u64 next_bucket;
+    u64 remaining;
+    const char* message;
+    usize length;
+} MergeCursor;
+
+static void NextMessage(MergeCursor* cursor)
+{
+    cursor->message = 0;
+    if (cursor->remaining == 0) { return; }
+    cursor->remaining--;
+    cursor->length = (usize)(GetNumber(&cursor->reader, 4));
+    cursor->message = GetBytes(&cursor->reader, cursor->length);
+}
+
+static s32 CompareCursors(MergeCursor* left, MergeCursor* right)
+{
+    usize length = (left->length < right->length) ? left->length : right->length;
+    s32 result = memcmp(left->message, right->message, length);
+    if (result != 0) { return result; }
+    return (left->length < right->length) ? -1 : (left->length > right->length);
+}
+
+// min heap of cursor indices ordered by their current message
+static void SiftDown(MergeCursor* cursors, usize* heap, usize heap_size, usize position)
+{
+    for (;;)
+    {
+        usize smallest = position;
+        usize left = position * 2 + 1;
+        usize right = left + 1;
+        if (left < heap_size && CompareCursors(&cursors[heap[left]], &cursors[heap[smallest]]) < 0) { smallest = left; }
+        if (right < heap_size && CompareCursors(&cursors[heap[right]], &cursors[heap[smallest]]) < 0) { smallest = right; }
+        if (smallest == position) { return; }
+        usize swap = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = swap;
+        position = smallest;
+    }
+}
+
+static void NextBucket(MessageTable* message_table, MergeCursor* cursor)
+{
+    cursor->next_bucket = message_table->bucket_count;
+    if (cursor->buckets_left == 0) { return; }
+    cursor->buckets_left--;
+    cursor->next_bucket = GetNumber(&cursor->reader, 4);
+    
+    // an index past the table ends this file, a truncated one is reported once the merge is done
+    if (cursor->reader.failed || cursor->next_bucket >= message_table->bucket_count) { cursor->next_bucket = message_table->bucket_count; }
+}
+
+static bool ReadBucketHeader(MessageTable* message_table, MergeCursor* cursor, MessageBucket* bucket, const char* path)
+{
+    usize name_length = (usize)(GetNumber(&cursor->reader, 2));
+    const char* name = GetBytes(&cursor->reader, name_length);
+    u64 count = GetNumber(&cursor->reader, 8);
+    cursor->remaining = GetNumber(&cursor->reader, 8);
+    if (cursor->reader.failed) 
+    { 
+        Log("--merge, %s is truncated\n", path);
+        return false; 
+    }
+    
+    char expected[128];
+    GetBucketName(message_table, bucket->index, expected, sizeof(expected));
+    if (name_length != StringLength(expected) || memcmp(name, expected, name_length) != 0)
+    {
+        Log("--merge, %s was written with a different config ([%.*s] where [%s] was expected)\n", path, (s32)(name_length), name, expected);
+        return false;
+    }
+    bucket->count += (usize)(count);
+    return true;
+}
+
+// text is scratch for null terminating each string, grown as needed
+static bool GetStrings(PartialReader* reader, StringVector* strings, bool deduplicate, char** text, usize* text_capacity)
+{
+    usize first_new = strings->size;
+    u64 count = GetNumber(reader, 4);
+    for (u64 i = 0; i < count && !reader->failed; i++)
+    {
+        usize length = (usize)(GetNumber(reader, 4));
+        const char* bytes = GetBytes(reader, length);
+        if (!bytes) { break; }
+        if (length + 1 > *text_capacity)
+        {
+            char* new_text = (char*)(realloc(*text, length + 1));
+            if (!new_text) { return false; }
+            *text = new_text;
+            *text_capacity = length + 1;
+        }
+        memcpy(*text, bytes, length);
+        (*text)[length] = '\0';
+        
+        if (deduplicate)
+        {
+            // every shard walks every directory, so their lists line up entry for entry with the one already merged
+            // a list walked in another order falls back to dropping names that were already listed
+            usize position = (usize)(i);
+            bool listed = position < first_new && StringCompare(strings->data[position], *text) == 0;
+            for (usize j = 0; j < first_new && !listed; j++) { listed = StringCompare(strings->data[j], *text) == 0; }
+            if (listed) { continue; }
+        }
+        StringVector_PushBack(strings, *text);
+    }
+    return true;
+}
+
+bool MergePartialResults(MessageTable* message_table, StringVector* paths)
+{
+    usize file_count = paths->size;
+    if (file_count == 0)
+    {
+        Log("--merge needs at least one partial results file\n");
+        return false;
+    }
+    
+    FileContents* files = (FileContents*)(calloc(file_count, sizeof(FileContents)));
+    MergeCursor* cursors = (MergeCursor*)(calloc(file_count, sizeof(MergeCursor)));
+    usize* heap = (usize*)(calloc(file_count, sizeof(usize)));
+    bool merged = files && cursors && heap;
+    char* message = 0;
+    usize message_capacity = 0;
+    
+    for (usize f = 0; f < file_count && merged; f++)
+    {
+        const char* path = paths->data[f];
+        usize size = GetFileContents(&files[f], path);
+        cursors[f].reader.at = (const u8*)(files[f].memory.buffer);
+        cursors[f].reader.end = cursors[f].reader.at + size;
+        
+        const char* magic = GetBytes(&cursors[f].reader, 4);
+        u64 version = GetNumber(&cursors[f].reader, 4);
+        u64 bucket_count = GetNumber(&cursors[f].reader, 4);
+        u64 match_count = GetNumber(&cursors[f].reader, 8);
+        if (!magic || memcmp(magic, PartialMagic, 4) != 0 || version != PartialVersion)
+        {
+            Log("--merge, %s is not a partial results file\n", path);
+            merged = false;
+        }
+        else if (bucket_count != message_table->bucket_count)
+        {
+            Log("--merge, %s was written with a different config (%llu buckets, expected %zu)\n", path, (unsigned long long)(bucket_count), message_table->bucket_count);
+            merged = false;
+        }
+        message_table->match_count += (usize)(match_count);
+        
+        merged = merged && GetStrings(&cursors[f].reader, &message_table->skipped_directories, true, &message, &message_capacity);
+        merged = merged && GetStrings(&cursors[f].reader, &message_table->skipped_files, false, &message, &message_capacity);
+        merged = merged && GetStrings(&cursors[f].reader, &message_table->empty_files, false, &message, &message_capacity);
+        cursors[f].buckets_left = GetNumber(&cursors[f].reader, 4);
+        if (merged) { NextBucket(message_table, &cursors[f]); }
+    }
+    
+    // buckets come out of every file in index order, so the lowest next bucket is the next one to merge
+    while (merged)
+    {
+        u64 b = message_table->bucket_count;
+        for (usize f = 0; f < file_count; f++) 
+        { 
+            if (cursors[f].next_bucket < b) { b = cursors[f].next_bucket; }
+        }
+        if (b == message_table->bucket_count) { break; }
+        
+        MessageBucket* bucket = AddBucket(message_table, (usize)(b));
+        if (!bucket) 
+        { 
+            merged = false; 
+            break; 
+        }
+        
+        usize heap_size = 0;
+        for (usize f = 0; f < file_count && merged; f++)
+        {
+            if (cursors[f].next_bucket != b) { continue; }
+            merged = ReadBucketHeader(message_table, &cursors[f], bucket, paths->data[f]);
+            NextMessage(&cursors[f]);
+            if (cursors[f].message) { heap[heap_size++] = f; }
+        }
+        for (usize i = heap_size; i > 0 && merged; i--) { SiftDown(cursors, heap, heap_size, i - 1); }
+        
+        // every file's messages are already sorted, so pulling the smallest head each time leaves the bucket sorted
+        while (heap_size > 0 && merged)
+        {
+            MergeCursor* cursor = &cursors[heap[0]];
+            if (cursor->length + 1 > message_capacity)
+            {
+                char* new_message = (char*)(realloc(message, cursor->length + 1));
+                if (!new_message) 
+                { 
+                    merged = false; 
+                    break; 
+                }
+                message = new_message;
+                message_capacity = cursor->length + 1;
+            }
+            memcpy(message, cursor->message, cursor->length);
+            message[cursor->length] = '\0';
+            StringVector_PushBack(&bucket->strings, message);
+            
+            NextMessage(cursor);
+            if (cursor->reader.failed)
+            {
+                Log("--merge, %s is truncated\n", paths->data[heap[0]]);
+                merged = false;
+            }
+            if (!cursor->message) { heap[0] = heap[--heap_size]; }
+            SiftDown(cursors, heap, heap_size, 0);
+        }
+        for (usize f = 0; f < file_count && merged; f++)
+        {
+            if (cursors[f].next_bucket == b) { NextBucket(message_table, &cursors[f]); }
+        }
+    }
+    
+    for (usize f = 0; f < file_count && merged; f++)
+    {
+        if (cursors[f].reader.failed)
+        {
+            Log("--merge, %s is truncated\n", paths->data[f]);
+            merged = false;
+        }
+    }
+    
+    for (usize f = 0; files && f < file_count; f++) { FreeFileContents(&files[f]); }
+    free(files);
+    free(cursors);
+    free(heap);
+    free(message);
+    return merged;
+}
@@ -44,30 +44,72 @@ static void GenericSwap(void* a, void* b, usize object_size)
     }
 }
 
-static usize GenericPartition(void* ptr, usize low, usize high, usize object_size, s32 (*Compare)(const void*, const void*)) 
+// median of the first, middle and last element, sorted and reversed input pick the middle instead of an end
+static char* MedianOfThree(char* array, usize low, usize high, usize object_size, s32 (*Compare)(const void*, const void*))
 {
-    char* array = (char*)ptr;
-    void* pivot = array + high * object_size;
-    usize i = low;
+    char* first = array + low * object_size;
+    char* middle = array + (low + (high - low) / 2) * object_size;
+    char* last = array + high * object_size;
     
-    for (usize j = low; j < high; j++) 
+    if (Compare(first, middle) > 0) 
+    { 
+        char* swap = first; 
+        first = middle; 
+        middle = swap; 
+    }
+    if (Compare(middle, last) > 0) 
+    { 
+        middle = (Compare(first, last) > 0) ? first : last; 
+    }
+    return middle;
+}
+
+// hoare partition around the median moved to low, both scans stop on elements equal to the pivot
+// so runs of equal elements split down the middle instead of all landing on one side
+// the pivot is copied out since the swaps move the element it came from
+static void GenericQuickSortRange(char* array, usize low, usize high, usize object_size, s32 (*Compare)(const void*, const void*), char* pivot)
+{
+    while (low < high) 
     {
-        if (Compare(array + j * object_size, pivot) <= 0) 
+        char* median = MedianOfThree(array, low, high, object_size, Compare);
+        if (median != array + low * object_size) { GenericSwap(array + low * object_size, median, object_size); }
+        memcpy(pivot, array + low * object_size, object_size);
+        
+        // [low, i) <= pivot and (j, high] >= pivot, with the pivot at low j always stops before high
+        usize i = low;
+        usize j = high;
+        for (;;)
         {
+            while (Compare(array + i * object_size, pivot) < 0) { i++; }
+            while (Compare(array + j * object_size, pivot) > 0) { j--; }
+            if (i >= j) { break; }
             GenericSwap(array + i * object_size, array + j * object_size, object_size);
             i++;
+            j--;
+        }
+        
+        // recurse into the smaller side and loop on the larger, the stack stays O(log n)
+        if (j - low < high - j)
+        {
+            GenericQuickSortRange(array, low, j, object_size, Compare, pivot);
+            low = j + 1;
+        }
+        else
+        {
+            GenericQuickSortRange(array, j + 1, high, object_size, Compare, pivot);
+            high = j;
         }
     }
-    GenericSwap(array + i * object_size, array + high * object_size, object_size);
-    return i;
 }
 
 void GenericQuickSort(void* ptr, usize low, usize high, usize object_size, s32 (*Compare)(const void*, const void*)) 
 {
-    if (low < high) 
-    {
-        usize partition = GenericPartition(ptr, low, high, object_size, Compare);
-        if (partition > low) { GenericQuickSort(ptr, low, partition - 1, object_size, Compare); }
-        if (partition < high) { GenericQuickSort(ptr, partition + 1, high, object_size, Compare); }
-    }
-}
\ No newline at end of file
+    if (low >= high) { return; }
+    
+    char pivot_buffer[256];
+    char* pivot = (object_size <= sizeof(pivot_buffer)) ? pivot_buffer : (char*)(malloc(object_size));
+    if (!pivot) { return; }
+    
+    GenericQuickSortRange((char*)(ptr), low, high, object_size, Compare, pivot);
+    if (pivot != pivot_buffer) { free(pivot); }
+}
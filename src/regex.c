@@ -0,0 +1,790 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// small regex engine for the [patterns] config section
+//
+// patterns are parsed into a tree, the tree is emitted as one thompson nfa program shared by every pattern,
+// and that program is turned into a dfa up front so searching a line is one table lookup per byte
+// the dfa only says which pattern matched first, the capture groups come from running a pike vm over
+// that one line for that one pattern, which is still linear but only happens on lines that matched
+//
+// supported: literals, . [abc] [^a-z] \d \w \s \D \W \S, escapes, ( ) (?: ) | * + ?
+
+//=====================================================================================================================
+// Parse
+//=====================================================================================================================
+typedef enum RegexNodeType
+{
+    RegexNode_Empty,
+    RegexNode_Class,
+    RegexNode_Concat,
+    RegexNode_Alternate,
+    RegexNode_Star,
+    RegexNode_Plus,
+    RegexNode_Quest,
+    RegexNode_Group,
+} RegexNodeType;
+
+typedef struct RegexNode
+{
+    RegexNodeType type;
+    s32 left;
+    s32 right;
+    s32 value; // class index for Class, capture group for Group (-1 when not capturing)
+} RegexNode;
+
+typedef struct RegexParser
+{
+    RegexSet* set;
+    const char* text;
+    RegexNode* nodes;
+    usize node_count;
+    usize node_capacity;
+    s32 group_count;
+    const char* error;
+} RegexParser;
+
+static s32 AddNode(RegexParser* parser, RegexNodeType type, s32 left, s32 right, s32 value)
+{
+    if (parser->node_count >= parser->node_capacity)
+    {
+        usize new_capacity = parser->node_capacity ? parser->node_capacity * 2 : 64;
+        RegexNode* new_nodes = (RegexNode*)(realloc(parser->nodes, new_capacity * sizeof(RegexNode)));
+        if (!new_nodes) { parser->error = "out of memory"; return -1; }
+        parser->nodes = new_nodes;
+        parser->node_capacity = new_capacity;
+    }
+    RegexNode* node = &parser->nodes[parser->node_count];
+    node->type = type;
+    node->left = left;
+    node->right = right;
+    node->value = value;
+    return (s32)(parser->node_count++);
+}
+
+static s32 AddClass(RegexParser* parser, RegexByteSet* byte_set)
+{
+    RegexSet* set = parser->set;
+    if (set->class_count >= set->class_capacity)
+    {
+        usize new_capacity = set->class_capacity ? set->class_capacity * 2 : 32;
+        RegexByteSet* new_classes = (RegexByteSet*)(realloc(set->classes, new_capacity * sizeof(RegexByteSet)));
+        if (!new_classes) { parser->error = "out of memory"; return -1; }
+        set->classes = new_classes;
+        set->class_capacity = new_capacity;
+    }
+    set->classes[set->class_count] = *byte_set;
+    return (s32)(set->class_count++);
+}
+
+static inline void ByteSetAdd(RegexByteSet* byte_set, u8 byte) { byte_set->bits[byte >> 5] |= (1u << (byte & 31)); }
+static inline bool ByteSetHas(const RegexByteSet* byte_set, u8 byte) { return (byte_set->bits[byte >> 5] >> (byte & 31)) & 1; }
+
+static void ByteSetAddRange(RegexByteSet* byte_set, u8 first, u8 last)
+{
+    for (u32 b = first; b <= last; b++) { ByteSetAdd(byte_set, (u8)(b)); }
+}
+
+static void ByteSetInvert(RegexByteSet* byte_set)
+{
+    for (usize i = 0; i < ArrayCount(byte_set->bits); i++) { byte_set->bits[i] = ~byte_set->bits[i]; }
+}
+
+// \d \w \s and friends, returns false if the character isn't a shorthand class
+static bool AddShorthandClass(RegexByteSet* byte_set, char c)
+{
+    RegexByteSet shorthand = {0};
+    switch (c)
+    {
+        case 'd': case 'D': ByteSetAddRange(&shorthand, '0', '9'); break;
+        case 'w': case 'W': 
+            ByteSetAddRange(&shorthand, '0', '9'); ByteSetAddRange(&shorthand, 'a', 'z'); 
+            ByteSetAddRange(&shorthand, 'A', 'Z'); ByteSetAdd(&shorthand, '_'); 
+            break;
+        case 's': case 'S': 
+            ByteSetAdd(&shorthand, ' '); ByteSetAdd(&shorthand, '\t'); ByteSetAdd(&shorthand, '\n'); 
+            ByteSetAdd(&shorthand, '\r'); ByteSetAdd(&shorthand, '\f'); ByteSetAdd(&shorthand, '\v'); 
+            break;
+        default: return false;
+    }
+    if (isupper((u8)(c))) { ByteSetInvert(&shorthand); }
+    for (usize i = 0; i < ArrayCount(shorthand.bits); i++) { byte_set->bits[i] |= shorthand.bits[i]; }
+    return true;
+}
+
+static char EscapedLiteral(char c)
+{
+    switch (c)
+    {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        default: return c;
+    }
+}
+
+static s32 ParseAlternate(RegexParser* parser);
+
+static s32 ParseBracket(RegexParser* parser)
+{
+    RegexByteSet byte_set = {0};
+    bool invert = false;
+    
+    parser->text++; // [
+    if (*parser->text == '^') { invert = true; parser->text++; }
+    
+    // a ] right at the start is a literal
+    bool first = true;
+    while (*parser->text && (*parser->text != ']' || first))
+    {
+        first = false;
+        char c = *parser->text++;
+        if (c == '\\' && *parser->text)
+        {
+            char escaped = *parser->text++;
+            if (AddShorthandClass(&byte_set, escaped)) { continue; }
+            c = EscapedLiteral(escaped);
+        }
+        
+        if (parser->text[0] == '-' && parser->text[1] && parser->text[1] != ']')
+        {
+            char last = parser->text[1];
+            parser->text += 2;
+            if (last == '\\' && *parser->text) { last = EscapedLiteral(*parser->text++); }
+            if ((u8)(last) < (u8)(c)) { parser->error = "bad range in []"; return -1; }
+            ByteSetAddRange(&byte_set, (u8)(c), (u8)(last));
+        }
+        else
+        {
+            ByteSetAdd(&byte_set, (u8)(c));
+        }
+    }
+    if (*parser->text != ']') { parser->error = "missing ]"; return -1; }
+    parser->text++;
+    
+    if (invert) { ByteSetInvert(&byte_set); }
+    s32 class_index = AddClass(parser, &byte_set);
+    if (class_index < 0) { return -1; }
+    return AddNode(parser, RegexNode_Class, -1, -1, class_index);
+}
+
+static s32 ParseAtom(RegexParser* parser)
+{
+    char c = *parser->text;
+    RegexByteSet byte_set = {0};
+    
+    if (c == '(')
+    {
+        parser->text++;
+        s32 group = -1;
+        if (parser->text[0] == '?' && parser->text[1] == ':') 
+        { 
+            parser->text += 2; 
+        }
+        else
+        {
+            if (parser->group_count >= RegexMaxGroups) { parser->error = "too many capture groups"; return -1; }
+            group = ++parser->group_count;
+        }
+        
+        s32 inner = ParseAlternate(parser);
+        if (inner < 0) { return -1; }
+        if (*parser->text != ')') { parser->error = "missing )"; return -1; }
+        parser->text++;
+        return AddNode(parser, RegexNode_Group, inner, -1, group);
+    }
+    if (c == '[') 
+    { 
+        return ParseBracket(parser); 
+    }
+    
+    parser->text++;
+    if (c == '.')
+    {
+        ByteSetInvert(&byte_set);
+        byte_set.bits['\n' >> 5] &= ~(1u << ('\n' & 31));
+    }
+    else if (c == '\\')
+    {
+        char escaped = *parser->text;
+        if (!escaped) { parser->error = "trailing \\"; return -1; }
+        parser->text++;
+        if (!AddShorthandClass(&byte_set, escaped)) { ByteSetAdd(&byte_set, (u8)(EscapedLiteral(escaped))); }
+    }
+    else if (c == '*' || c == '+' || c == '?')
+    {
+        parser->error = "nothing to repeat";
+        return -1;
+    }
+    else
+    {
+        ByteSetAdd(&byte_set, (u8)(c));
+    }
+    
+    s32 class_index = AddClass(parser, &byte_set);
+    if (class_index < 0) { return -1; }
+    return AddNode(parser, RegexNode_Class, -1, -1, class_index);
+}
+
+static s32 ParseRepeat(RegexParser* parser)
+{
+    s32 node = ParseAtom(parser);
+    while (node >= 0)
+    {
+        char c = *parser->text;
+        if (c == '*') { node = AddNode(parser, RegexNode_Star, node, -1, 0); }
+        else if (c == '+') { node = AddNode(parser, RegexNode_Plus, node, -1, 0); }
+        else if (c == '?') { node = AddNode(parser, RegexNode_Quest, node, -1, 0); }
+        else { break; }
+        parser->text++;
+    }
+    return node;
+}
+
+static s32 ParseConcat(RegexParser* parser)
+{
+    s32 node = -1;
+    while (*parser->text && *parser->text != '|' && *parser->text != ')')
+    {
+        s32 next = ParseRepeat(parser);
+        if (next < 0) { return -1; }
+        node = (node < 0) ? next : AddNode(parser, RegexNode_Concat, node, next, 0);
+    }
+    if (node < 0) { node = AddNode(parser, RegexNode_Empty, -1, -1, 0); }
+    return node;
+}
+
+static s32 ParseAlternate(RegexParser* parser)
+{
+    s32 node = ParseConcat(parser);
+    while (node >= 0 && *parser->text == '|')
+    {
+        parser->text++;
+        s32 right = ParseConcat(parser);
+        if (right < 0) { return -1; }
+        node = AddNode(parser, RegexNode_Alternate, node, right, 0);
+    }
+    return node;
+}
+
+//=====================================================================================================================
+// Emit nfa program
+//=====================================================================================================================
+static s32 Emit(RegexSet* set, RegexOp op, s32 x, s32 y)
+{
+    if (set->instruction_count >= set->instruction_capacity)
+    {
+        usize new_capacity = set->instruction_capacity ? set->instruction_capacity * 2 : 128;
+        RegexInstruction* new_program = (RegexInstruction*)(realloc(set->program, new_capacity * sizeof(RegexInstruction)));
+        if (!new_program) { return -1; }
+        set->program = new_program;
+        set->instruction_capacity = new_capacity;
+    }
+    RegexInstruction* instruction = &set->program[set->instruction_count];
+    instruction->op = op;
+    instruction->x = x;
+    instruction->y = y;
+    return (s32)(set->instruction_count++);
+}
+
+// split and jump targets are patched once the code after them exists
+static bool EmitNode(RegexSet* set, RegexNode* nodes, s32 index)
+{
+    RegexNode* node = &nodes[index];
+    switch (node->type)
+    {
+        case RegexNode_Empty: 
+            return true;
+        case RegexNode_Class: 
+            return Emit(set, RegexOp_Class, node->value, 0) >= 0;
+        case RegexNode_Concat: 
+            return EmitNode(set, nodes, node->left) && EmitNode(set, nodes, node->right);
+        case RegexNode_Group:
+        {
+            if (node->value < 0) { return EmitNode(set, nodes, node->left); }
+            if (Emit(set, RegexOp_Save, node->value * 2, 0) < 0) { return false; }
+            if (!EmitNode(set, nodes, node->left)) { return false; }
+            return Emit(set, RegexOp_Save, node->value * 2 + 1, 0) >= 0;
+        }
+        case RegexNode_Alternate:
+        {
+            s32 split = Emit(set, RegexOp_Split, 0, 0);
+            if (split < 0) { return false; }
+            set->program[split].x = split + 1;
+            if (!EmitNode(set, nodes, node->left)) { return false; }
+            s32 jump = Emit(set, RegexOp_Jump, 0, 0);
+            if (jump < 0) { return false; }
+            set->program[split].y = (s32)(set->instruction_count);
+            if (!EmitNode(set, nodes, node->right)) { return false; }
+            set->program[jump].x = (s32)(set->instruction_count);
+            return true;
+        }
+        case RegexNode_Star:
+        {
+            s32 split = Emit(set, RegexOp_Split, 0, 0);
+            if (split < 0) { return false; }
+            set->program[split].x = split + 1;
+            if (!EmitNode(set, nodes, node->left)) { return false; }
+            if (Emit(set, RegexOp_Jump, split, 0) < 0) { return false; }
+            set->program[split].y = (s32)(set->instruction_count);
+            return true;
+        }
+        case RegexNode_Plus:
+        {
+            s32 start = (s32)(set->instruction_count);
+            if (!EmitNode(set, nodes, node->left)) { return false; }
+            s32 split = Emit(set, RegexOp_Split, start, 0);
+            if (split < 0) { return false; }
+            set->program[split].y = split + 1;
+            return true;
+        }
+        case RegexNode_Quest:
+        {
+            s32 split = Emit(set, RegexOp_Split, 0, 0);
+            if (split < 0) { return false; }
+            set->program[split].x = split + 1;
+            if (!EmitNode(set, nodes, node->left)) { return false; }
+            set->program[split].y = (s32)(set->instruction_count);
+            return true;
+        }
+    }
+    return false;
+}
+
+//=====================================================================================================================
+// Build dfa
+//=====================================================================================================================
+// bytes that every class treats the same way share one column in the dfa table
+static void BuildByteClasses(RegexSet* set)
+{
+    memset(set->byte_class, 0, sizeof(set->byte_class));
+    set->byte_class_count = 1;
+    
+    for (usize c = 0; c < set->class_count; c++)
+    {
+        s16 split_to[256 * 2];
+        for (usize i = 0; i < ArrayCount(split_to); i++) { split_to[i] = -1; }
+        
+        usize new_count = 0;
+        for (u32 b = 0; b < 256; b++)
+        {
+            usize key = set->byte_class[b] * 2 + (ByteSetHas(&set->classes[c], (u8)(b)) ? 1 : 0);
+            if (split_to[key] < 0) { split_to[key] = (s16)(new_count++); }
+            set->byte_class[b] = (u16)(split_to[key]);
+        }
+        set->byte_class_count = new_count;
+    }
+    
+    for (u32 b = 0; b < 256; b++) { set->byte_class_representative[set->byte_class[b]] = (u8)(b); }
+}
+
+// follows split/jump/save from pc, adds the consuming instructions to the list
+static void AddClosure(RegexSet* set, s32 pc, s32* list, usize* count, u32* seen, u32 generation)
+{
+    if (seen[pc] == generation) { return; }
+    seen[pc] = generation;
+    
+    RegexInstruction* instruction = &set->program[pc];
+    switch (instruction->op)
+    {
+        case RegexOp_Jump:  AddClosure(set, instruction->x, list, count, seen, generation); break;
+        case RegexOp_Save:  AddClosure(set, pc + 1, list, count, seen, generation); break;
+        case RegexOp_Split: 
+            AddClosure(set, instruction->x, list, count, seen, generation); 
+            AddClosure(set, instruction->y, list, count, seen, generation); 
+            break;
+        case RegexOp_Class:
+        case RegexOp_Match:
+            list[(*count)++] = pc;
+            break;
+    }
+}
+
+static s32 Compare_S32(const void* a, const void* b) { return *(const s32*)(a) - *(const s32*)(b); }
+
+static u64 HashStateSet(const s32* list, usize count)
+{
+    u64 hash = 14695981039346656037ull;
+    for (usize i = 0; i < count; i++) { hash = (hash ^ (u64)(list[i])) * 1099511628211ull; }
+    return hash;
+}
+
+typedef struct DfaBuilder
+{
+    RegexSet* set;
+    s32* state_sets;         // every dfa state's nfa pc list back to back
+    usize* state_set_offsets;
+    usize* state_set_counts;
+    usize state_sets_size;
+    usize state_sets_capacity;
+    s32* hash_slots;         // open addressing, -1 is empty
+    usize hash_slot_count;
+} DfaBuilder;
+
+// returns the dfa state for this set of nfa pcs, adding it if it is new
+static s32 FindOrAddState(DfaBuilder* builder, s32* list, usize count)
+{
+    RegexSet* set = builder->set;
+    if (count > 1) { GenericQuickSort(list, 0, count - 1, sizeof(s32), Compare_S32); }
+    
+    u64 hash = HashStateSet(list, count);
+    usize slot = hash & (builder->hash_slot_count - 1);
+    while (builder->hash_slots[slot] >= 0)
+    {
+        s32 state = builder->hash_slots[slot];
+        if (builder->state_set_counts[state] == count && 
+            memcmp(builder->state_sets + builder->state_set_offsets[state], list, count * sizeof(s32)) == 0)
+        {
+            return state;
+        }
+        slot = (slot + 1) & (builder->hash_slot_count - 1);
+    }
+    
+    if (set->state_count >= RegexMaxDfaStates) { return -1; }
+    
+    if (builder->state_sets_size + count > builder->state_sets_capacity)
+    {
+        usize new_capacity = (builder->state_sets_capacity + count) * 2;
+        s32* new_sets = (s32*)(realloc(builder->state_sets, new_capacity * sizeof(s32)));
+        if (!new_sets) { return -1; }
+        builder->state_sets = new_sets;
+        builder->state_sets_capacity = new_capacity;
+    }
+    
+    s32 state = (s32)(set->state_count++);
+    memcpy(builder->state_sets + builder->state_sets_size, list, count * sizeof(s32));
+    builder->state_set_offsets[state] = builder->state_sets_size;
+    builder->state_set_counts[state] = count;
+    builder->state_sets_size += count;
+    builder->hash_slots[slot] = state;
+    
+    u32 accept = 0;
+    for (usize i = 0; i < count; i++)
+    {
+        RegexInstruction* instruction = &set->program[list[i]];
+        if (instruction->op == RegexOp_Match) { accept |= (1u << instruction->x); }
+    }
+    set->accept[state] = accept;
+    return state;
+}
+
+// subset construction, every state also contains the start of every pattern so the search is unanchored
+static bool BuildDfa(RegexSet* set)
+{
+    usize program_size = set->instruction_count;
+    usize class_count = set->byte_class_count;
+    
+    DfaBuilder builder = {0};
+    builder.set = set;
+    builder.hash_slot_count = RegexMaxDfaStates * 2;
+    builder.hash_slots = (s32*)(malloc(builder.hash_slot_count * sizeof(s32)));
+    builder.state_set_offsets = (usize*)(malloc(RegexMaxDfaStates * sizeof(usize)));
+    builder.state_set_counts = (usize*)(malloc(RegexMaxDfaStates * sizeof(usize)));
+    set->transitions = (s32*)(malloc(RegexMaxDfaStates * class_count * sizeof(s32)));
+    set->accept = (u32*)(malloc(RegexMaxDfaStates * sizeof(u32)));
+    s32* list = (s32*)(malloc(program_size * sizeof(s32)));
+    u32* seen = (u32*)(calloc(program_size, sizeof(u32)));
+    
+    bool ok = builder.hash_slots && builder.state_set_offsets && builder.state_set_counts && set->transitions && set->accept && list && seen;
+    u32 generation = 0;
+    
+    if (ok)
+    {
+        for (usize i = 0; i < builder.hash_slot_count; i++) { builder.hash_slots[i] = -1; }
+        
+        usize count = 0;
+        generation++;
+        for (usize p = 0; p < set->pattern_count; p++) { AddClosure(set, set->pattern_entries[p], list, &count, seen, generation); }
+        ok = FindOrAddState(&builder, list, count) == 0;
+    }
+    
+    // states are added to the end as they are found, so walking the list in order visits all of them
+    for (usize state = 0; ok && state < set->state_count; state++)
+    {
+        for (usize c = 0; ok && c < class_count; c++)
+        {
+            u8 byte = set->byte_class_representative[c];
+            usize count = 0;
+            generation++;
+            
+            const s32* from = builder.state_sets + builder.state_set_offsets[state];
+            for (usize i = 0; i < builder.state_set_counts[state]; i++)
+            {
+                RegexInstruction* instruction = &set->program[from[i]];
+                if (instruction->op == RegexOp_Class && ByteSetHas(&set->classes[instruction->x], byte))
+                {
+                    AddClosure(set, from[i] + 1, list, &count, seen, generation);
+                }
+            }
+            for (usize p = 0; p < set->pattern_count; p++) { AddClosure(set, set->pattern_entries[p], list, &count, seen, generation); }
+            
+            s32 next = FindOrAddState(&builder, list, count);
+            if (next < 0) { ok = false; break; }
+            set->transitions[state * class_count + c] = next;
+        }
+    }
+    
+    free(builder.state_sets);
+    free(builder.state_set_offsets);
+    free(builder.state_set_counts);
+    free(builder.hash_slots);
+    free(list);
+    free(seen);
+    return ok;
+}
+
+//=====================================================================================================================
+// Public
+//=====================================================================================================================
+bool RegexSet_Compile(RegexSet* set, const char** patterns, usize pattern_count, char* error, usize error_size)
+{
+    memset(set, 0, sizeof(RegexSet));
+    if (pattern_count == 0) { return true; }
+    if (pattern_count > RegexMaxPatterns)
+    {
+        snprintf(error, error_size, "too many patterns, the limit is %d", RegexMaxPatterns);
+        return false;
+    }
+    
+    set->pattern_entries = (s32*)(malloc(pattern_count * sizeof(s32)));
+    set->pattern_group_counts = (s32*)(malloc(pattern_count * sizeof(s32)));
+    if (!set->pattern_entries || !set->pattern_group_counts)
+    {
+        snprintf(error, error_size, "out of memory");
+        RegexSet_Free(set);
+        return false;
+    }
+    
+    for (usize p = 0; p < pattern_count; p++)
+    {
+        RegexParser parser = {0};
+        parser.set = set;
+        parser.text = patterns[p];
+        
+        s32 root = ParseAlternate(&parser);
+        if (root >= 0 && *parser.text) { parser.error = "unmatched )"; }
+        
+        bool ok = !parser.error && root >= 0;
+        if (ok)
+        {
+            // group 0 is the whole match
+            set->pattern_entries[p] = (s32)(set->instruction_count);
+            set->pattern_group_counts[p] = parser.group_count;
+            ok = Emit(set, RegexOp_Save, 0, 0) >= 0 &&
+                 EmitNode(set, parser.nodes, root) &&
+                 Emit(set, RegexOp_Save, 1, 0) >= 0 &&
+                 Emit(set, RegexOp_Match, (s32)(p), 0) >= 0;
+            if (!ok) { parser.error = "out of memory"; }
+        }
+        free(parser.nodes);
+        
+        if (!ok)
+        {
+            snprintf(error, error_size, "%s: %s", patterns[p], parser.error ? parser.error : "bad pattern");
+            RegexSet_Free(set);
+            return false;
+        }
+        set->pattern_count++;
+    }
+    
+    BuildByteClasses(set);
+    if (!BuildDfa(set))
+    {
+        snprintf(error, error_size, "patterns need more than %d dfa states", RegexMaxDfaStates);
+        RegexSet_Free(set);
+        return false;
+    }
+    if (!RegexScratch_Init(&set->scratch, set))
+    {
+        snprintf(error, error_size, "out of memory");
+        RegexSet_Free(set);
+        return false;
+    }
+    return true;
+}
+
+void RegexSet_Free(RegexSet* set)
+{
+    RegexScratch_Free(&set->scratch);
+    free(set->classes);
+    free(set->program);
+    free(set->pattern_entries);
+    free(set->pattern_group_counts);
+    free(set->transitions);
+    free(set->accept);
+    memset(set, 0, sizeof(RegexSet));
+}
+
+s32 RegexSet_Find(RegexSet* set, const char* start, const char* end)
+{
+    if (set->pattern_count == 0) { return -1; }
+    
+    const s32* transitions = set->transitions;
+    const u16* byte_class = set->byte_class;
+    usize class_count = set->byte_class_count;
+    
+    s32 state = 0;
+    u32 accept = set->accept[0];
+    for (const char* c = start; !accept && c < end; c++)
+    {
+        state = transitions[state * class_count + byte_class[(u8)(*c)]];
+        accept = set->accept[state];
+    }
+    if (!accept) { return -1; }
+    
+    // lowest pattern index wins when several finish on the same byte
+    s32 pattern = 0;
+    while (!(accept & (1u << pattern))) { pattern++; }
+    return pattern;
+}
+
+// pike vm, threads are kept in priority order so the first thread to match is the leftmost-first match
+typedef struct RegexThread
+{
+    s32 pc;
+    const char* saved[RegexMaxGroups * 2 + 2];
+} RegexThread;
+
+typedef struct RegexThreadList
+{
+    RegexThread* threads;
+    usize count;
+} RegexThreadList;
+
+static void AddThread(RegexSet* set, RegexThreadList* list, u32* seen, u32 generation, s32 pc, const char** saved, const char* at)
+{
+    if (seen[pc] == generation) { return; }
+    seen[pc] = generation;
+    
+    RegexInstruction* instruction = &set->program[pc];
+    switch (instruction->op)
+    {
+        case RegexOp_Jump: AddThread(set, list, seen, generation, instruction->x, saved, at); break;
+        case RegexOp_Split:
+            AddThread(set, list, seen, generation, instruction->x, saved, at);
+            AddThread(set, list, seen, generation, instruction->y, saved, at);
+            break;
+        case RegexOp_Save:
+        {
+            const char* previous = saved[instruction->x];
+            saved[instruction->x] = at;
+            AddThread(set, list, seen, generation, pc + 1, saved, at);
+            saved[instruction->x] = previous;
+            break;
+        }
+        case RegexOp_Class:
+        case RegexOp_Match:
+        {
+            RegexThread* thread = &list->threads[list->count++];
+            thread->pc = pc;
+            memcpy(thread->saved, saved, sizeof(thread->saved));
+            break;
+        }
+    }
+}
+
+bool RegexScratch_Init(RegexScratch* scratch, RegexSet* set)
+{
+    usize program_size = set->instruction_count;
+    scratch->threads = (RegexThread*)(malloc(program_size * 2 * sizeof(RegexThread)));
+    scratch->seen = (u32*)(calloc(program_size, sizeof(u32)));
+    scratch->generation = 0;
+    if (!scratch->threads || !scratch->seen)
+    {
+        RegexScratch_Free(scratch);
+        return false;
+    }
+    return true;
+}
+
+void RegexScratch_Free(RegexScratch* scratch)
+{
+    free(scratch->threads);
+    free(scratch->seen);
+    memset(scratch, 0, sizeof(RegexScratch));
+}
+
+bool RegexSet_Match(RegexSet* set, RegexScratch* scratch, s32 pattern, const char* start, const char* end, RegexMatch* match)
+{
+    memset(match, 0, sizeof(RegexMatch));
+    if (pattern < 0 || (usize)(pattern) >= set->pattern_count || !scratch->threads) { return false; }
+    
+    // a line can't take more generations than it has bytes plus one, start over before the stamp wraps
+    usize program_size = set->instruction_count;
+    usize length = (usize)(end - start);
+    if (length + 2 >= (usize)(0xFFFFFFFFu - scratch->generation))
+    {
+        memset(scratch->seen, 0, program_size * sizeof(u32));
+        scratch->generation = 0;
+    }
+    u32* seen = scratch->seen;
+    
+    RegexThreadList current = { scratch->threads, 0 };
+    RegexThreadList next = { scratch->threads + program_size, 0 };
+    const char* saved[RegexMaxGroups * 2 + 2] = {0};
+    u32 generation = ++scratch->generation;
+    bool matched = false;
+    
+    for (const char* at = start; ; at++)
+    {
+        // start a new attempt here unless something to the left already matched
+        if (!matched) { AddThread(set, &current, seen, generation, set->pattern_entries[pattern], saved, at); }
+        if (current.count == 0) { break; }
+        
+        generation++;
+        next.count = 0;
+        for (usize i = 0; i < current.count; i++)
+        {
+            RegexThread* thread = &current.threads[i];
+            RegexInstruction* instruction = &set->program[thread->pc];
+            if (instruction->op == RegexOp_Match)
+            {
+                matched = true;
+                memcpy(match->saved, thread->saved, sizeof(match->saved));
+                break; // lower priority threads lose
+            }
+            if (at < end && ByteSetHas(&set->classes[instruction->x], (u8)(*at)))
+            {
+                AddThread(set, &next, seen, generation, thread->pc + 1, thread->saved, at + 1);
+            }
+        }
+        
+        RegexThreadList swap = current;
+        current = next;
+        next = swap;
+        if (at >= end) { break; }
+    }
+    scratch->generation = generation;
+    
+    if (matched)
+    {
+        match->start = match->saved[0];
+        match->end = match->saved[1];
+        match->group_count = (usize)(set->pattern_group_counts[pattern]);
+    }
+    return matched;
+}
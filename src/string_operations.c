@@ -70,4 +70,199 @@ bool StringEndsWith(const char *string, const char* suffix)
     
     usize suffix_start_index = string_length - suffix_length;
     return StringCompare(&string[suffix_start_index], suffix) == 0;
-}
\ No newline at end of file
+}
+const char* FindFirstOfBytes(const char* start, const char* end, const u8* bytes, usize byte_count)
+{
+    const char* current = start;
+    
+#ifdef SIMD_SSE2
+    // 16 bytes at a time, compare against every byte we are looking for and or the results together
+    // the bit mask of the combined compare tells us where the first hit is
+    __m128i needles[8];
+    usize needle_count = (byte_count <= ArrayCount(needles)) ? byte_count : 0;
+    for (usize i = 0; i < needle_count; i++) { needles[i] = _mm_set1_epi8((char)(bytes[i])); }
+    
+    while (needle_count && current + 16 <= end)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(current));
+        __m128i hits = _mm_cmpeq_epi8(block, needles[0]);
+        for (usize i = 1; i < needle_count; i++) { hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[i])); }
+        
+        u32 mask = (u32)(_mm_movemask_epi8(hits));
+        if (mask)
+        {
+#ifdef _MSC_VER
+            unsigned long first = 0;
+            _BitScanForward(&first, mask);
+            return current + first;
+#else
+            return current + __builtin_ctz(mask);
+#endif
+        }
+        current += 16;
+    }
+#endif
+
+    for (; current < end; current++)
+    {
+        for (usize i = 0; i < byte_count; i++)
+        {
+            if ((u8)(*current) == bytes[i]) { return current; }
+        }
+    }
+    return end;
+}
+
+bool StringMatchesFolded(const char* text, usize available, const char* folded_pattern, usize length)
+{
+    if (length > available) { return false; }
+    usize i = 0;
+    
+#ifdef SIMD_SSE2
+    // fold a whole block at once, upper case letters get 0x20 or'd in
+    // bytes >= 0x80 are negative as signed chars so they never land in the A-Z range
+    // the last block may hang past the pattern, those lanes are masked off
+    const __m128i before_a = _mm_set1_epi8('A' - 1);
+    const __m128i after_z = _mm_set1_epi8('Z' + 1);
+    const __m128i fold_bit = _mm_set1_epi8(0x20);
+    for (; i < length && i + 16 <= available; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i is_upper = _mm_and_si128(_mm_cmpgt_epi8(block, before_a), _mm_cmplt_epi8(block, after_z));
+        __m128i folded = _mm_or_si128(block, _mm_and_si128(is_upper, fold_bit));
+        __m128i pattern = _mm_loadu_si128((const __m128i*)(folded_pattern + i));
+        
+        u32 wanted = (length - i >= 16) ? 0xFFFF : ((1u << (length - i)) - 1);
+        u32 equal = (u32)(_mm_movemask_epi8(_mm_cmpeq_epi8(folded, pattern)));
+        if ((equal & wanted) != wanted) { return false; }
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (FoldCase(text[i]) != folded_pattern[i]) { return false; }
+    }
+    return true;
+}
+
+Utf16Order DetectUtf16(const u8* data, usize size, usize* bom_size)
+{
+    *bom_size = 0;
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xFE)
+    {
+        // FF FE 00 00 is a utf-32 bom, not ours
+        if (size >= 4 && data[2] == 0 && data[3] == 0) { return Utf16Order_None; }
+        *bom_size = 2;
+        return Utf16Order_LittleEndian;
+    }
+    if (size >= 2 && data[0] == 0xFE && data[1] == 0xFF)
+    {
+        *bom_size = 2;
+        return Utf16Order_BigEndian;
+    }
+    
+    // no bom, mostly ascii text leaves the high byte of nearly every code unit zero
+    // and the low byte almost never, anything else is left to the binary check
+    usize sample = (size < 512 ? size : 512) & ~(usize)(1);
+    usize pairs = sample / 2;
+    if (pairs < 4) { return Utf16Order_None; }
+    
+    usize even_zeros = 0;
+    usize odd_zeros = 0;
+    for (usize i = 0; i < sample; i += 2)
+    {
+        even_zeros += (data[i] == 0);
+        odd_zeros += (data[i + 1] == 0);
+    }
+    if (odd_zeros * 10 >= pairs * 9 && even_zeros * 20 < pairs) { return Utf16Order_LittleEndian; }
+    if (even_zeros * 10 >= pairs * 9 && odd_zeros * 20 < pairs) { return Utf16Order_BigEndian; }
+    return Utf16Order_None;
+}
+
+static inline u32 ReadCodeUnit(const u8* at, Utf16Order order)
+{
+    return (order == Utf16Order_BigEndian) ? ((u32)(at[0]) << 8 | at[1]) : ((u32)(at[1]) << 8 | at[0]);
+}
+
+usize TranscodeUtf16(const u8** source, const u8* source_end, Utf16Order order, char* destination, usize destination_size)
+{
+    const u8* current = *source;
+    usize written = 0;
+    
+    while (current + 2 <= source_end)
+    {
+#ifdef SIMD_SSE2
+        // 16 code units at a time, when they are all ascii the saturating pack is the whole conversion
+        // big endian units get their bytes swapped first
+        if (current + 32 <= source_end && written + 16 <= destination_size)
+        {
+            __m128i low = _mm_loadu_si128((const __m128i*)(current));
+            __m128i high = _mm_loadu_si128((const __m128i*)(current + 16));
+            if (order == Utf16Order_BigEndian)
+            {
+                low = _mm_or_si128(_mm_slli_epi16(low, 8), _mm_srli_epi16(low, 8));
+                high = _mm_or_si128(_mm_slli_epi16(high, 8), _mm_srli_epi16(high, 8));
+            }
+            __m128i above_ascii = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16((short)(0xFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(above_ascii, _mm_setzero_si128())) == 0xFFFF)
+            {
+                _mm_storeu_si128((__m128i*)(destination + written), _mm_packus_epi16(low, high));
+                current += 32;
+                written += 16;
+                continue;
+            }
+        }
+#endif
+        
+        // one block's worth one unit at a time, then the fast path gets another try
+        const u8* block_end = (current + 32 <= source_end) ? current + 32 : source_end;
+        while (current + 2 <= block_end)
+        {
+            u32 code_point = ReadCodeUnit(current, order);
+            usize used = 2;
+            if (code_point >= 0xD800 && code_point <= 0xDBFF)
+            {
+                u32 next = (current + 4 <= source_end) ? ReadCodeUnit(current + 2, order) : 0;
+                if (next >= 0xDC00 && next <= 0xDFFF)
+                {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (next - 0xDC00);
+                    used = 4;
+                }
+                else { code_point = 0xFFFD; }
+            }
+            else if (code_point >= 0xDC00 && code_point <= 0xDFFF) { code_point = 0xFFFD; }
+            
+            usize length = (code_point < 0x80) ? 1 : (code_point < 0x800) ? 2 : (code_point < 0x10000) ? 3 : 4;
+            if (written + length > destination_size) 
+            {
+                *source = current;
+                return written;
+            }
+            
+            char* out = destination + written;
+            switch (length)
+            {
+                case 1: out[0] = (char)(code_point); break;
+                case 2:
+                    out[0] = (char)(0xC0 | (code_point >> 6));
+                    out[1] = (char)(0x80 | (code_point & 0x3F));
+                    break;
+                case 3:
+                    out[0] = (char)(0xE0 | (code_point >> 12));
+                    out[1] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+                    out[2] = (char)(0x80 | (code_point & 0x3F));
+                    break;
+                default:
+                    out[0] = (char)(0xF0 | (code_point >> 18));
+                    out[1] = (char)(0x80 | ((code_point >> 12) & 0x3F));
+                    out[2] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+                    out[3] = (char)(0x80 | (code_point & 0x3F));
+                    break;
+            }
+            current += used;
+            written += length;
+        }
+    }
+    *source = current;
+    return written;
+}
@@ -30,8 +30,8 @@ void StringVector_Init(StringVector* vec)
     if(!vec) return;
     if(vec->data) 
     { 
-        for (usize i = 0; i < vec->size; i++) { free(vec->data[i]); }
-        free(vec->data); 
+        for (usize i = 0; i < vec->size; i++) { TaggedFree(vec->data[i]); }
+        TaggedFree(vec->data); 
     } 
     vec->data = 0;
     vec->size = 0;
@@ -50,7 +50,7 @@ void StringVector_PushBack(StringVector* vec, const char* string)
     {
         const usize starting_capacity = 8;
         usize new_capacity = (vec->capacity < starting_capacity) ? starting_capacity : vec->capacity * 2;
-        char** new_data = realloc(vec->data, new_capacity * sizeof(char*));
+        char** new_data = TaggedRealloc(AllocationTag_StringVector, vec->data, new_capacity * sizeof(char*));
         if (!new_data) 
         {
             LogDebug("Failed to reallocate memory for string vector");
@@ -61,7 +61,7 @@ void StringVector_PushBack(StringVector* vec, const char* string)
     }
     
     usize length = StringLength(string);
-    vec->data[vec->size] = (char*)(malloc(length + 1));
+    vec->data[vec->size] = (char*)(TaggedMalloc(AllocationTag_StringVector, length + 1));
     
     if (!vec->data[vec->size]) 
     {
@@ -84,8 +84,8 @@ void StringVector_PushArray(StringVector* vec, const char** array, usize count)
 
 void StringVector_Free(StringVector* vec) 
 {
-    for (usize i = 0; i < vec->size; i++) { free(vec->data[i]); }
-    free(vec->data);
+    for (usize i = 0; i < vec->size; i++) { TaggedFree(vec->data[i]); }
+    TaggedFree(vec->data);
     vec->data = 0;
     vec->size = 0; 
     vec->capacity = 0;
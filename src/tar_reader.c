@@ -0,0 +1,245 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// sequential tar reader, headers and member data are read straight off the stream in order
+// nothing seeks, skipping a member just reads past it, so it works the same on a file or a gzip stream
+// understands ustar, gnu long names (L) and pax path records (x)
+
+#define TarBlockSize 512
+
+static bool ReadExactly(TarReader* reader, u8* destination, usize count)
+{
+    usize total = 0;
+    while (total < count)
+    {
+        usize read = reader->read(reader->stream, destination + total, count - total);
+        if (read == 0) { return false; }
+        total += read;
+    }
+    return true;
+}
+
+static bool SkipBytes(TarReader* reader, u64 count)
+{
+    u8 scratch[4096];
+    while (count > 0)
+    {
+        usize chunk = (count < sizeof(scratch)) ? (usize)(count) : sizeof(scratch);
+        if (!ReadExactly(reader, scratch, chunk)) { return false; }
+        count -= chunk;
+    }
+    return true;
+}
+
+// octal, or base 256 with the top bit set for sizes that don't fit in 11 octal digits
+static u64 ParseTarNumber(const u8* field, usize length)
+{
+    u64 value = 0;
+    if (field[0] & 0x80)
+    {
+        value = field[0] & 0x7F;
+        for (usize i = 1; i < length; i++) { value = (value << 8) | field[i]; }
+        return value;
+    }
+    for (usize i = 0; i < length && field[i]; i++)
+    {
+        if (field[i] == ' ') { continue; }
+        if (field[i] < '0' || field[i] > '7') { break; }
+        value = (value << 3) | (u64)(field[i] - '0');
+    }
+    return value;
+}
+
+static bool IsZeroBlock(const u8* block)
+{
+    for (usize i = 0; i < TarBlockSize; i++) 
+    { 
+        if (block[i]) { return false; } 
+    }
+    return true;
+}
+
+static bool ChecksumMatches(const u8* block)
+{
+    u64 stored = ParseTarNumber(block + 148, 8);
+    u64 sum = 0;
+    for (usize i = 0; i < TarBlockSize; i++) 
+    { 
+        sum += (i >= 148 && i < 156) ? ' ' : block[i]; 
+    }
+    return sum == stored;
+}
+
+static void CopyField(char* destination, usize destination_size, const u8* field, usize field_length)
+{
+    usize length = 0;
+    while (length < field_length && field[length]) { length++; }
+    if (length >= destination_size) { length = destination_size - 1; }
+    memcpy(destination, field, length);
+    destination[length] = '\0';
+}
+
+// pax records are "<length> <key>=<value>\n", we only care about path
+static void ParsePaxPath(const char* records, usize size, char* path, usize path_size)
+{
+    usize position = 0;
+    while (position < size)
+    {
+        usize record_length = 0;
+        usize cursor = position;
+        while (cursor < size && isdigit((u8)(records[cursor]))) { record_length = record_length * 10 + (records[cursor++] - '0'); }
+        if (record_length == 0 || position + record_length > size || cursor >= size || records[cursor] != ' ') { return; }
+        cursor++;
+        
+        const char* key = records + cursor;
+        const char* record_end = records + position + record_length - 1; // drop the \n
+        if (record_end - key > 5 && memcmp(key, "path=", 5) == 0)
+        {
+            usize length = record_end - (key + 5);
+            if (length >= path_size) { length = path_size - 1; }
+            memcpy(path, key + 5, length);
+            path[length] = '\0';
+        }
+        position += record_length;
+    }
+}
+
+// reads a whole small member (long name or pax header) into a string
+static bool ReadMetadataMember(TarReader* reader, u64 size, char* destination, usize destination_size)
+{
+    usize keep = (size < destination_size - 1) ? (usize)(size) : destination_size - 1;
+    if (!ReadExactly(reader, (u8*)(destination), keep)) { return false; }
+    destination[keep] = '\0';
+    u64 padded = (size + TarBlockSize - 1) & ~(u64)(TarBlockSize - 1);
+    return SkipBytes(reader, padded - keep);
+}
+
+void TarOpen(TarReader* reader, StreamReadFunction read, void* stream)
+{
+    memset(reader, 0, sizeof(TarReader));
+    reader->read = read;
+    reader->stream = stream;
+}
+
+bool TarNextMember(TarReader* reader, TarMember* member)
+{
+    if (reader->error || reader->finished) { return false; }
+    
+    // whatever the caller didn't read of the last member, plus its padding
+    if (!SkipBytes(reader, reader->remaining + reader->padding))
+    {
+        reader->error = true;
+        return false;
+    }
+    reader->remaining = 0;
+    reader->padding = 0;
+    
+    char long_path[MaxPath] = {0};
+    char pax_path[MaxPath] = {0};
+    
+    u8 block[TarBlockSize];
+    for (;;)
+    {
+        if (!ReadExactly(reader, block, sizeof(block)))
+        {
+            // archives cut off right after a member still gave us everything they had
+            reader->finished = true;
+            return false;
+        }
+        if (IsZeroBlock(block))
+        {
+            reader->finished = true;
+            return false;
+        }
+        if (!ChecksumMatches(block))
+        {
+            LogDebug("TarNextMember, bad header checksum\n");
+            reader->error = true;
+            return false;
+        }
+        
+        u64 size = ParseTarNumber(block + 124, 12);
+        char type = (char)(block[156]);
+        
+        if (type == 'L')
+        {
+            if (!ReadMetadataMember(reader, size, long_path, sizeof(long_path))) { reader->error = true; return false; }
+            continue;
+        }
+        if (type == 'x')
+        {
+            char records[MaxPath * 2];
+            if (!ReadMetadataMember(reader, size, records, sizeof(records))) { reader->error = true; return false; }
+            ParsePaxPath(records, StringLength(records), pax_path, sizeof(pax_path));
+            continue;
+        }
+        
+        memset(member, 0, sizeof(TarMember));
+        member->size = size;
+        member->type = (type == '0' || type == '\0' || type == '7') ? FileType_File : ((type == '5') ? FileType_Directory : FileType_Other);
+        
+        if (pax_path[0]) 
+        { 
+            StringCopy_NullTerminate(member->path, pax_path, sizeof(member->path)); 
+        }
+        else if (long_path[0]) 
+        { 
+            StringCopy_NullTerminate(member->path, long_path, sizeof(member->path)); 
+        }
+        else
+        {
+            // ustar splits long names into prefix/name
+            char name[101];
+            char prefix[156];
+            CopyField(name, sizeof(name), block, 100);
+            CopyField(prefix, sizeof(prefix), block + 345, 155);
+            bool ustar = memcmp(block + 257, "ustar", 5) == 0;
+            if (ustar && prefix[0]) { snprintf(member->path, sizeof(member->path), "%s/%s", prefix, name); }
+            else { StringCopy_NullTerminate(member->path, name, sizeof(member->path)); }
+        }
+        
+        // links and directories carry no data, everything else does
+        reader->remaining = (type == '1' || type == '2' || type == '3' || type == '4' || type == '5' || type == '6') ? 0 : size;
+        reader->padding = ((reader->remaining + TarBlockSize - 1) & ~(u64)(TarBlockSize - 1)) - reader->remaining;
+        return true;
+    }
+}
+
+usize TarReadMember(TarReader* reader, u8* destination, usize count)
+{
+    if (reader->error || reader->remaining == 0) { return 0; }
+    if (count > reader->remaining) { count = (usize)(reader->remaining); }
+    
+    usize read = reader->read(reader->stream, destination, count);
+    if (read == 0) 
+    { 
+        reader->error = true; 
+        return 0;
+    }
+    reader->remaining -= read;
+    return read;
+}
@@ -0,0 +1,94 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+
+#include "common.h"
+
+#ifdef OS_Win32
+static DWORD WINAPI ThreadEntry(LPVOID data)
+{
+    Thread* thread = (Thread*)(data);
+    thread->function(thread->data);
+    ReleaseThreadLogRing();
+    return 0;
+}
+#else
+static void* ThreadEntry(void* data)
+{
+    Thread* thread = (Thread*)(data);
+    thread->function(thread->data);
+    ReleaseThreadLogRing();
+    return 0;
+}
+#endif
+
+bool Thread_Start(Thread* thread, ThreadFunction function, void* data)
+{
+    thread->function = function;
+    thread->data = data;
+#ifdef OS_Win32
+    thread->handle = CreateThread(0, 0, ThreadEntry, thread, 0, 0);
+    thread->started = (thread->handle != 0);
+#else
+    thread->started = (pthread_create(&thread->handle, 0, ThreadEntry, thread) == 0);
+#endif
+    if (!thread->started) { LogDebug("Thread_Start, could not start a thread\n"); }
+    return thread->started;
+}
+
+void Thread_Join(Thread* thread)
+{
+    if (!thread->started) { return; }
+#ifdef OS_Win32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, 0);
+#endif
+    thread->started = false;
+}
+
+void Thread_Sleep(u32 milliseconds)
+{
+#ifdef OS_Win32
+    Sleep(milliseconds);
+#else
+    struct timespec duration = { (time_t)(milliseconds / 1000), (long)(milliseconds % 1000) * 1000000L };
+    nanosleep(&duration, 0);
+#endif
+}
+
+usize GetProcessorCount()
+{
+#ifdef OS_Win32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    usize count = (usize)(info.dwNumberOfProcessors);
+#else
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    usize count = (online > 0) ? (usize)(online) : 1;
+#endif
+    return count ? count : 1;
+}
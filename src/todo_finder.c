@@ -0,0 +1,136 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// the library side of todo_finder.h
+// a TodoFinder only remembers where its config is, every scan builds and frees its own MessageTable
+// so nothing is shared between scans and nothing calls Exit
+struct TodoFinder
+{
+    char config_path[MaxPath];
+    bool has_config;
+    usize match_count;
+};
+
+TodoFinder* TodoFinder_Create(const char* config_path)
+{
+    if (config_path && GetPathType(config_path) != FileType_File)
+    {
+        Log("TodoFinder_Create, %s is not a config file\n", config_path);
+        return 0;
+    }
+    
+    TodoFinder* finder = (TodoFinder*)(calloc(1, sizeof(TodoFinder)));
+    if (!finder) { return 0; }
+    
+    if (config_path)
+    {
+        StringCopy_NullTerminate(finder->config_path, config_path, sizeof(finder->config_path));
+        finder->has_config = true;
+    }
+    return finder;
+}
+
+void TodoFinder_Destroy(TodoFinder* finder)
+{
+    free(finder);
+}
+
+// these are acted on by main after the scan, a library scan would accept them and quietly do nothing
+static bool HasOnlyLibraryOptions(UserArguments* arguments)
+{
+    const char* option = 0;
+    if (arguments->emit_partial) { option = "--emit-partial"; }
+    else if (arguments->merge) { option = "--merge"; }
+    else if (arguments->save_baseline) { option = "--save-baseline"; }
+    else if (arguments->diff_baseline) { option = "--diff-baseline"; }
+    else if (arguments->log_level) { option = "--log-level"; }
+    
+    if (option) { Log("TodoFinder_Scan, %s is only available from the command line\n", option); }
+    return option == 0;
+}
+
+TodoFinderResult TodoFinder_Scan(TodoFinder* finder, int argument_count, const char** arguments, TodoFinderMatchCallback on_match, void* user_data)
+{
+    if (!finder || argument_count < 0) { return TodoFinder_BadArguments; }
+    finder->match_count = 0;
+    
+    // the config is read again for every scan, the table takes ownership of it
+    UserConfig* user_config = finder->has_config ? LoadUserConfig(finder->config_path) : 0;
+    if (!IsUserConfigUsable(user_config))
+    {
+        FreeUserConfig(user_config);
+        return TodoFinder_ConfigError;
+    }
+    MessageTable* message_table = AllocateMessageTable(user_config);
+    if (!message_table) { return TodoFinder_OutOfMemory; }
+    
+    // ParseUserArguments skips the program name like main does
+    char** argv = (char**)(malloc((argument_count + 1) * sizeof(char*)));
+    if (!argv)
+    {
+        FreeMessageTable(message_table);
+        return TodoFinder_OutOfMemory;
+    }
+    argv[0] = "todo_finder";
+    for (int i = 0; i < argument_count; i++) { argv[i + 1] = (char*)(arguments[i]); }
+    
+    TodoFinderResult result = TodoFinder_Ok;
+    if (!ParseUserArguments(&message_table->arguments, argument_count + 1, argv))
+    {
+        result = TodoFinder_BadArguments;
+    }
+    else if (!HasOnlyLibraryOptions(&message_table->arguments))
+    {
+        result = TodoFinder_BadArguments;
+    }
+    else
+    {
+        // no callback means the host only wants the count, don't keep messages nobody will read
+        message_table->match_callback = on_match;
+        message_table->match_user_data = user_data;
+        if (!on_match) { message_table->arguments.count_only = true; }
+        
+        if (!ProcessUserRequest(message_table))
+        {
+            result = message_table->scan_failed ? TodoFinder_ScanFailed : TodoFinder_BadArguments;
+        }
+        else if (message_table->exit_code != 0)
+        {
+            result = TodoFinder_FailOnMatched;
+        }
+    }
+    
+    finder->match_count = message_table->match_count;
+    free(argv);
+    FreeMessageTable(message_table);
+    return result;
+}
+
+size_t TodoFinder_GetMatchCount(const TodoFinder* finder)
+{
+    return finder ? finder->match_count : 0;
+}
@@ -0,0 +1,103 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+// todo_finder as a library, build with ./build_compiler_gcc.sh <config> library and link libtodo_finder.a or .so
+// this header is all a host needs, it doesn't pull in anything from common.h
+//
+// every TodoFinder is independent, scans on different TodoFinders can run on different threads at the same time
+// a single TodoFinder runs one scan at a time
+// logging is the exception, the log callback is shared by every TodoFinder in the process
+// matches are handed to the callback as they are found, nothing is printed, logged to a file or sorted
+//
+//     static int OnMatch(const TodoFinderMatch* match, void* user_data)
+//     {
+//         printf("%s:%d %.*s\n", match->path, match->line_number, (int)match->text_length, match->text);
+//         return 0;
+//     }
+//
+//     TodoFinder* finder = TodoFinder_Create(0);
+//     const char* arguments[] = { "--comments-only", "src" };
+//     TodoFinderResult result = TodoFinder_Scan(finder, 2, arguments, OnMatch, 0);
+//     TodoFinder_Destroy(finder);
+
+#ifndef TODO_FINDER_H
+#define TODO_FINDER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TodoFinder TodoFinder;
+
+typedef enum TodoFinderResult
+{
+    TodoFinder_Ok = 0,
+    TodoFinder_FailOnMatched,  // a --fail-on keyword was found, the command line exits with 1 for this
+    TodoFinder_BadArguments,   // the reason was sent to the log callback
+    TodoFinder_ScanFailed,     // a directory couldn't be opened, the scan stopped there
+    TodoFinder_OutOfMemory,
+    TodoFinder_ConfigError     // the config has no [symbols] or no keywords, the reason was sent to the log callback
+} TodoFinderResult;
+
+typedef struct TodoFinderMatch
+{
+    const char* path;
+    int line_number;
+    const char* symbol;  // 0 for [patterns] matches
+    const char* keyword; // the keyword, or the pattern for [patterns] matches
+    const char* text;    // from the match to the end of the line, not nul terminated
+    size_t text_length;
+} TodoFinderMatch;
+
+// everything passed to a callback is only valid for the length of the call
+// return non zero from the match callback to stop the scan
+typedef int  (*TodoFinderMatchCallback)(const TodoFinderMatch* match, void* user_data);
+typedef void (*TodoFinderLogCallback)(const char* message, void* user_data);
+
+// config_path is a .todo_config file, 0 uses the built in defaults
+// returns 0 when out of memory
+TodoFinder* TodoFinder_Create(const char* config_path);
+void        TodoFinder_Destroy(TodoFinder* finder);
+
+// arguments are the same as the command line options, without the program name
+// --rollup-*, -C and anything else that only changes printing is accepted and ignored
+// --emit-partial, --merge, --save-baseline and --diff-baseline write or read files only the command line handles, they are TodoFinder_BadArguments
+// --log-level is TodoFinder_BadArguments too, the level is process wide and one scan's arguments would change every other scan's logging
+TodoFinderResult TodoFinder_Scan(TodoFinder* finder, int argument_count, const char** arguments, TodoFinderMatchCallback on_match, void* user_data);
+
+// matches seen by the last scan
+size_t TodoFinder_GetMatchCount(const TodoFinder* finder);
+
+// process wide, set it before starting any scans
+// the library is silent without one, warnings like a bad [patterns] entry only go here
+void TodoFinder_SetLogCallback(TodoFinderLogCallback log, void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TODO_FINDER_H
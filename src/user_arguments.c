@@ -0,0 +1,249 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+#include "common.h"
+
+// parses a whole positive number, returns false on anything else
+static bool ParseCount(const char* text, usize* count)
+{
+    if(!text || !*text) { return false; }
+    
+    usize value = 0;
+    for(const char* c = text; *c; ++c)
+    {
+        if(!isdigit((u8)(*c))) { return false; }
+        value = value * 10 + (usize)(*c - '0');
+    }
+    *count = value;
+    return true;
+}
+
+// i/N with i < N
+static bool ParseShard(const char* text, usize* index, usize* count)
+{
+    if(!text) { return false; }
+    const char* slash = strchr(text, '/');
+    if(!slash || slash == text) { return false; }
+    
+    char index_text[32];
+    usize index_length = (usize)(slash - text);
+    if(index_length >= sizeof(index_text)) { return false; }
+    memcpy(index_text, text, index_length);
+    index_text[index_length] = '\0';
+    
+    return ParseCount(index_text, index) && ParseCount(slash + 1, count) && *count > 0 && *index < *count;
+}
+
+void PrintUsage()
+{
+    Log("usage: todo_finder [options] [directories or files...]\n\n");
+    Log("    searches the current directory when no directories or files are given\n\n");
+    Log("    --fail-on <keyword>   stop at the first match of <keyword> and exit with code 1\n");
+    Log("    --max-results <n>     stop after <n> matches\n");
+    Log("    --count-only          only count matches per [symbol][keyword], no messages\n");
+    Log("    --rollup-depth <n>    print match counts per directory, <n> levels deep\n");
+    Log("    --rollup-summary      only print the per directory counts, implies --count-only\n");
+    Log("    --comments-only       ignore matches outside of comments (c style, #, lua, html/xml)\n");
+    Log("    --files-from <file>   search the paths listed in <file>, - reads stdin, nul or newline separated\n");
+    Log("    -C, --context <n>     show <n> lines before and after each match\n");
+    Log("    --shard <i>/<n>       only search the files that hash to shard <i> of <n>, 0 based\n");
+    Log("    --emit-partial <file> write the results to <file> for --merge instead of printing them\n");
+    Log("    --merge <files...>    print one report from partial results files, nothing is searched\n");
+    Log("    --deadline <ms>       search the most recently modified files first and stop after <ms> milliseconds\n");
+    Log("    --save-baseline <file> write a fingerprint of every match to <file> for a later --diff-baseline\n");
+    Log("    --diff-baseline <file> only print the matches added or removed since <file> was saved\n");
+    Log("    --diff <file>         only search the lines a unified diff adds, - reads stdin (git diff --cached | todo_finder --diff -)\n");
+    Log("    --inode-order         search each directory's files in inode order with readahead, faster on cold caches\n");
+    Log("    --one-file-system     don't cross into directories mounted from another device\n");
+    Log("    --mem-stats           print allocations, realloc churn and peak memory per subsystem, debug builds\n");
+    Log("    --log-level <level>   info or debug, debug adds per file diagnostics\n");
+    Log("\n");
+}
+
+bool ParseUserArguments(UserArguments* arguments, s32 argc, char** argv)
+{
+    if(!arguments) { return false; }
+    memset(arguments, 0, sizeof(UserArguments));
+    
+    for(s32 i = 1; i < argc; ++i)
+    {
+        const char* argument = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : 0;
+        
+        if(StringCompare(argument, "--fail-on") == 0)
+        {
+            if(!value) { Log("--fail-on needs a keyword\n"); return false; }
+            arguments->fail_on_keyword = value;
+            i++;
+        }
+        else if(StringCompare(argument, "--max-results") == 0)
+        {
+            if(!ParseCount(value, &arguments->max_results) || arguments->max_results == 0) 
+            { 
+                Log("--max-results needs a number greater than 0\n"); 
+                return false; 
+            }
+            i++;
+        }
+        else if(StringCompare(argument, "--count-only") == 0)
+        {
+            arguments->count_only = true;
+        }
+        else if(StringCompare(argument, "--rollup-depth") == 0)
+        {
+            if(!ParseCount(value, &arguments->rollup_depth)) 
+            { 
+                Log("--rollup-depth needs a number\n"); 
+                return false; 
+            }
+            arguments->rollup = true;
+            i++;
+        }
+        else if(StringCompare(argument, "--rollup-summary") == 0)
+        {
+            // keeps whatever depth was asked for, otherwise shows the top level directories
+            if(!arguments->rollup) { arguments->rollup_depth = 1; }
+            arguments->rollup = true;
+            arguments->count_only = true;
+        }
+        else if(StringCompare(argument, "--comments-only") == 0)
+        {
+            arguments->comments_only = true;
+        }
+        else if(StringCompare(argument, "--files-from") == 0)
+        {
+            if(!value) { Log("--files-from needs a file, or - for stdin\n"); return false; }
+            arguments->files_from = value;
+            i++;
+        }
+        else if(StringCompare(argument, "-C") == 0 || StringCompare(argument, "--context") == 0)
+        {
+            if(!ParseCount(value, &arguments->context_lines)) 
+            { 
+                Log("%s needs a number of lines\n", argument); 
+                return false; 
+            }
+            i++;
+        }
+        else if(StringCompare(argument, "--shard") == 0)
+        {
+            if(!ParseShard(value, &arguments->shard_index, &arguments->shard_count))
+            {
+                Log("--shard needs <i>/<n> with i less than n, like 0/4\n");
+                return false;
+            }
+            i++;
+        }
+        else if(StringCompare(argument, "--emit-partial") == 0)
+        {
+            if(!value) { Log("--emit-partial needs a file to write\n"); return false; }
+            arguments->emit_partial = value;
+            i++;
+        }
+        else if(StringCompare(argument, "--merge") == 0)
+        {
+            arguments->merge = true;
+        }
+        else if(StringCompare(argument, "--deadline") == 0)
+        {
+            usize milliseconds = 0;
+            if(!ParseCount(value, &milliseconds) || milliseconds == 0) 
+            { 
+                Log("--deadline needs a number of milliseconds greater than 0\n"); 
+                return false; 
+            }
+            arguments->deadline_ms = milliseconds;
+            i++;
+        }
+        else if(StringCompare(argument, "--save-baseline") == 0)
+        {
+            if(!value) { Log("--save-baseline needs a file to write\n"); return false; }
+            arguments->save_baseline = value;
+            i++;
+        }
+        else if(StringCompare(argument, "--diff-baseline") == 0)
+        {
+            if(!value) { Log("--diff-baseline needs a baseline file\n"); return false; }
+            arguments->diff_baseline = value;
+            i++;
+        }
+        else if(StringCompare(argument, "--diff") == 0)
+        {
+            if(!value) { Log("--diff needs a unified diff file, or - for stdin\n"); return false; }
+            arguments->diff = value;
+            i++;
+        }
+        else if(StringCompare(argument, "--mem-stats") == 0)
+        {
+            arguments->mem_stats = true;
+        }
+        else if(StringCompare(argument, "--log-level") == 0)
+        {
+            s32 level;
+            if(!value || !ParseLogLevel(value, &level)) { Log("--log-level needs info or debug\n"); return false; }
+            arguments->log_level = value;
+            i++;
+        }
+        else if(StringCompare(argument, "--inode-order") == 0)
+        {
+            arguments->inode_order = true;
+        }
+        else if(StringCompare(argument, "--one-file-system") == 0)
+        {
+            arguments->one_file_system = true;
+        }
+        else if(argument[0] == '-' && argument[1] == '-')
+        {
+            Log("unknown option: %s\n", argument);
+            return false;
+        }
+        else
+        {
+            StringVector_PushBack(&arguments->roots, argument);
+        }
+    }
+    
+    if(arguments->merge && (arguments->emit_partial || arguments->files_from || arguments->shard_count))
+    {
+        Log("--merge only reads partial results, it can't be combined with --emit-partial, --files-from or --shard\n");
+        return false;
+    }
+    if((arguments->save_baseline || arguments->diff_baseline) && (arguments->merge || arguments->emit_partial))
+    {
+        Log("baselines are made while searching, --save-baseline and --diff-baseline can't be combined with --merge or --emit-partial\n");
+        return false;
+    }
+    if(arguments->diff && (arguments->roots.size || arguments->files_from || arguments->merge))
+    {
+        Log("--diff searches the files named in the diff, it can't be combined with other paths, --files-from or --merge\n");
+        return false;
+    }
+    if(arguments->deadline_ms && arguments->rollup)
+    {
+        Log("--deadline searches files out of directory order, it can't be combined with --rollup-depth or --rollup-summary\n");
+        return false;
+    }
+    return true;
+}
@@ -27,6 +27,8 @@
 
 const char* symbols_identifier = "[symbols]";
 const char* keywords_identifier = "[keywords]";
+const char* case_insensitive_keywords_identifier = "[case insensitive keywords]";
+const char* patterns_identifier = "[patterns]";
 const char* ignore_directories_identifier = "[ignore directories]";
 const char* ignore_extensions_identifier = "[ignore extensions]";
 
@@ -35,6 +37,8 @@ typedef enum ConfigSection
     ConfigSection_None,
     ConfigSection_Symbols,
     ConfigSection_Keywords,
+    ConfigSection_CaseInsensitiveKeywords,
+    ConfigSection_Patterns,
     ConfigSection_IgnoreDirectories,
     ConfigSection_IgnoreExtensions
 }ConfigSection;
@@ -43,31 +47,64 @@ static void ParseConfigFile(UserConfig* user_config, FileContents* config_file);
 static bool FindUserConfigFile(UserConfig* user_config);
 
 UserConfig* GetUserConfig()
+{
+    UserConfig search = {0};
+    if(!FindUserConfigFile(&search)) { return 0; }
+    return LoadUserConfig(search.path);
+}
+
+UserConfig* LoadUserConfig(const char* path)
 {
     UserConfig* user_config = (UserConfig*)( malloc(sizeof(UserConfig)) );
     if(!user_config) 
     {
-        LogDebug("GetUserConfig, failed to allocate user config\n");
+        LogDebug("LoadUserConfig, failed to allocate user config\n");
         return 0;
     }
     memset(user_config, 0, sizeof(UserConfig));
+    StringCopy_NullTerminate(user_config->path, path, ArrayCount(user_config->path));
     
-    bool found_user_config = FindUserConfigFile(user_config);
-    if(found_user_config)
+    FileContents config_file = {0};
+    usize size = GetFileContents(&config_file, user_config->path);
+    if (size == 0) 
     {
-        FileContents config_file = {0};
-        usize size = GetFileContents(&config_file, user_config->path);
-        if (size == 0) 
-        {
-            LogDebug("GetUserConfig, config file is empty\n");
-            return 0;
-        }
-        
-        ParseConfigFile(user_config, &config_file);
-        FreeFileContents(&config_file);
-        return user_config;
+        LogDebug("LoadUserConfig, config file is empty\n");
+        free(user_config);
+        return 0;
+    }
+    
+    ParseConfigFile(user_config, &config_file);
+    FreeFileContents(&config_file);
+    return user_config;
+}
+
+// a table needs at least one symbol and one keyword, a [patterns] section on its own isn't enough
+bool IsUserConfigUsable(UserConfig* user_config)
+{
+    if (!user_config) { return true; }
+    if (user_config->symbols.size == 0)
+    {
+        Log("%s has no [symbols]\n", user_config->path);
+        return false;
+    }
+    if (user_config->keywords.size + user_config->case_insensitive_keywords.size == 0)
+    {
+        Log("%s has no [keywords] or [case insensitive keywords]\n", user_config->path);
+        return false;
     }
-    return 0;
+    return true;
+}
+
+void FreeUserConfig(UserConfig* user_config)
+{
+    if (!user_config) { return; }
+    StringVector_Free(&user_config->symbols);
+    StringVector_Free(&user_config->keywords);
+    StringVector_Free(&user_config->case_insensitive_keywords);
+    StringVector_Free(&user_config->regex_patterns);
+    StringVector_Free(&user_config->ignore_directories);
+    StringVector_Free(&user_config->ignore_extensions);
+    free(user_config);
 }
 
 static bool FindUserConfigFile(UserConfig* user_config)
@@ -143,6 +180,8 @@ static void ParseConfigFile(UserConfig* user_config, FileContents* config_file)
             
             if (StringCompare(current_pos, symbols_identifier) == 0) { current_section = ConfigSection_Symbols; } 
             else if (StringCompare(current_pos, keywords_identifier) == 0) { current_section = ConfigSection_Keywords; } 
+            else if (StringCompare(current_pos, case_insensitive_keywords_identifier) == 0) { current_section = ConfigSection_CaseInsensitiveKeywords; } 
+            else if (StringCompare(current_pos, patterns_identifier) == 0) { current_section = ConfigSection_Patterns; } 
             else if (StringCompare(current_pos, ignore_directories_identifier) == 0) { current_section = ConfigSection_IgnoreDirectories; } 
             else if (StringCompare(current_pos, ignore_extensions_identifier) == 0) { current_section = ConfigSection_IgnoreExtensions; } 
             else { current_section = ConfigSection_None; }
@@ -178,6 +217,8 @@ static void ParseConfigFile(UserConfig* user_config, FileContents* config_file)
                         case ConfigSection_None: LogDebug("ParseConfigFile, stray token not within any section\n"); break;
                         case ConfigSection_Symbols: StringVector_PushBack(&user_config->symbols, token); break;
                         case ConfigSection_Keywords: StringVector_PushBack(&user_config->keywords, token); break;
+                        case ConfigSection_CaseInsensitiveKeywords: StringVector_PushBack(&user_config->case_insensitive_keywords, token); break;
+                        case ConfigSection_Patterns: StringVector_PushBack(&user_config->regex_patterns, token); break;
                         case ConfigSection_IgnoreDirectories: StringVector_PushBack(&user_config->ignore_directories, token); break;
                         case ConfigSection_IgnoreExtensions: StringVector_PushBack(&user_config->ignore_extensions, token); break;
                     }
@@ -0,0 +1,275 @@
+//=====================================================================================================================
+// MIT License
+//
+// Copyright (c) 2025 Cory Simonich
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//=====================================================================================================================
+
+// build time generator for the baked matcher, see the baked option in build_compiler_gcc.sh
+//
+//     generate_matcher <config> <output header>
+//
+// loads the config with the same code the program uses, so keyword order and case flags come out identical
+// then writes a header with everything about [symbols] and [keywords] turned into constants
+//     a perfect hash of each keyword's first two (folded) bytes, keywords sharing a prefix share a slot
+//     constant simd masks for the symbol bytes
+//     an unrolled compare for every keyword, switch on the hash then byte by byte against immediates
+// the program checks the fingerprint of whatever config it loads and only uses this when it matches
+//
+// exits non zero for configs it can't bake, the build script then builds the normal dynamic matcher
+
+#include "../src/common.h"
+
+#define MaxBakedKeywords 4096
+
+typedef struct Prefix
+{
+    u8 first;
+    u8 second;
+} Prefix;
+
+static u8 FoldByte(u8 c) { return (u8)(FoldCase((char)(c))); }
+
+static u32 Hash(u32 seed, u32 bits, u8 first, u8 second)
+{
+    return (((u32)(first) | ((u32)(second) << 8)) * seed) >> (32 - bits);
+}
+
+// any odd multiplier that keeps every distinct prefix in its own slot
+static bool FindSeed(Prefix* prefixes, usize prefix_count, u32* seed, u32* bits)
+{
+    u8* used = (u8*)(malloc(1 << 16));
+    if (!used) { return false; }
+    
+    u32 start_bits = 1;
+    while (((usize)(1) << start_bits) < prefix_count * 2) { start_bits++; }
+    
+    u32 candidate = 0x9E3779B1u;
+    for (u32 try_bits = start_bits; try_bits <= 16; try_bits++)
+    {
+        for (u32 attempt = 0; attempt < 100000; attempt++)
+        {
+            candidate = candidate * 1664525u + 1013904223u;
+            u32 odd = candidate | 1;
+            memset(used, 0, (usize)(1) << try_bits);
+            
+            bool collided = false;
+            for (usize p = 0; p < prefix_count && !collided; p++)
+            {
+                u32 slot = Hash(odd, try_bits, prefixes[p].first, prefixes[p].second);
+                collided = used[slot] != 0;
+                used[slot] = 1;
+            }
+            if (!collided)
+            {
+                *seed = odd;
+                *bits = try_bits;
+                free(used);
+                return true;
+            }
+        }
+    }
+    free(used);
+    return false;
+}
+
+static void WriteByteCompare(FILE* out, const char* text, usize offset, u8 byte, bool folded)
+{
+    if (folded && isalpha(byte)) { fprintf(out, " && FoldCase(%s[%zu]) == 0x%02X", text, offset, FoldByte(byte)); }
+    else { fprintf(out, " && (u8)(%s[%zu]) == 0x%02X", text, offset, byte); }
+}
+
+s32 main(s32 argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: generate_matcher <config> <output header>\n");
+        return 1;
+    }
+    
+    UserConfig* user_config = LoadUserConfig(argv[1]);
+    if (!user_config)
+    {
+        fprintf(stderr, "generate_matcher, couldn't read %s\n", argv[1]);
+        return 1;
+    }
+    MessageTable* message_table = AllocateMessageTable(user_config);
+    if (!message_table)
+    {
+        fprintf(stderr, "generate_matcher, %s has no usable [symbols] or [keywords]\n", argv[1]);
+        return 1;
+    }
+    
+    StringVector* symbols = &message_table->symbols;
+    StringVector* keywords = &message_table->keywords;
+    bool any_case_insensitive = false;
+    for (usize k = 0; k < keywords->size; k++) 
+    { 
+        any_case_insensitive |= message_table->keyword_case_insensitive && message_table->keyword_case_insensitive[k]; 
+    }
+    
+    // the shapes the baked matcher can't reproduce exactly stay dynamic
+    if (keywords->size > MaxBakedKeywords)
+    {
+        fprintf(stderr, "generate_matcher, more than %d keywords\n", MaxBakedKeywords);
+        return 1;
+    }
+    for (usize s = 0; s < symbols->size; s++)
+    {
+        const char* symbol = symbols->data[s];
+        if (!symbol[0])
+        {
+            fprintf(stderr, "generate_matcher, empty symbols can't be baked\n");
+            return 1;
+        }
+        for (const char* c = symbol; *c && any_case_insensitive; c++)
+        {
+            if (isalpha((u8)(*c)))
+            {
+                fprintf(stderr, "generate_matcher, symbol %s has letters and there are case insensitive keywords\n", symbol);
+                return 1;
+            }
+        }
+    }
+    
+    Prefix* prefixes = (Prefix*)(calloc(keywords->size, sizeof(Prefix)));
+    usize prefix_count = 0;
+    for (usize k = 0; k < keywords->size; k++)
+    {
+        const char* keyword = keywords->data[k];
+        if (StringLength(keyword) < 2)
+        {
+            fprintf(stderr, "generate_matcher, keyword %s is shorter than the two byte hash key\n", keyword);
+            return 1;
+        }
+        Prefix prefix = { FoldByte((u8)(keyword[0])), FoldByte((u8)(keyword[1])) };
+        bool seen = false;
+        for (usize p = 0; p < prefix_count && !seen; p++) { seen = prefixes[p].first == prefix.first && prefixes[p].second == prefix.second; }
+        if (!seen) { prefixes[prefix_count++] = prefix; }
+    }
+    
+    u32 seed = 0;
+    u32 bits = 0;
+    if (!FindSeed(prefixes, prefix_count, &seed, &bits))
+    {
+        fprintf(stderr, "generate_matcher, no perfect hash found\n");
+        return 1;
+    }
+    
+    FILE* out = fopen(argv[2], "w");
+    if (!out)
+    {
+        fprintf(stderr, "generate_matcher, couldn't write %s\n", argv[2]);
+        return 1;
+    }
+    
+    fprintf(out, "// generated by tools/generate_matcher.c from %s, do not edit\n", argv[1]);
+    fprintf(out, "// %zu symbols, %zu keywords, %zu hash slots in use out of %u\n\n", symbols->size, keywords->size, prefix_count, 1u << bits);
+    fprintf(out, "#define BakedMatcher_Fingerprint 0x%016llXull\n\n", (unsigned long long)(GetMatcherFingerprint(message_table)));
+    
+    // symbol scan
+    u8 symbol_bytes[256];
+    usize symbol_byte_count = 0;
+    for (usize s = 0; s < symbols->size; s++)
+    {
+        u8 byte = (u8)(symbols->data[s][0]);
+        bool seen = false;
+        for (usize i = 0; i < symbol_byte_count && !seen; i++) { seen = symbol_bytes[i] == byte; }
+        if (!seen) { symbol_bytes[symbol_byte_count++] = byte; }
+    }
+    
+    fprintf(out, "// first byte of any symbol in [start, end), end when there isn't one\n");
+    fprintf(out, "static inline const char* BakedFindSymbol(const char* start, const char* end)\n{\n");
+    fprintf(out, "    const char* current = start;\n");
+    fprintf(out, "#ifdef SIMD_SSE2\n");
+    for (usize i = 0; i < symbol_byte_count; i++) { fprintf(out, "    const __m128i mask_%zu = _mm_set1_epi8((char)(0x%02X));\n", i, symbol_bytes[i]); }
+    fprintf(out, "    while (current + 16 <= end)\n    {\n");
+    fprintf(out, "        __m128i block = _mm_loadu_si128((const __m128i*)(current));\n");
+    fprintf(out, "        __m128i hits = _mm_cmpeq_epi8(block, mask_0);\n");
+    for (usize i = 1; i < symbol_byte_count; i++) { fprintf(out, "        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, mask_%zu));\n", i); }
+    fprintf(out, "        u32 mask = (u32)(_mm_movemask_epi8(hits));\n");
+    fprintf(out, "        if (mask)\n        {\n");
+    fprintf(out, "#ifdef _MSC_VER\n            unsigned long first = 0;\n            _BitScanForward(&first, mask);\n            return current + first;\n");
+    fprintf(out, "#else\n            return current + __builtin_ctz(mask);\n#endif\n        }\n");
+    fprintf(out, "        current += 16;\n    }\n#endif\n");
+    fprintf(out, "    for (; current < end; current++)\n    {\n        switch ((u8)(*current))\n        {\n");
+    for (usize i = 0; i < symbol_byte_count; i++) { fprintf(out, "            case 0x%02X:\n", symbol_bytes[i]); }
+    fprintf(out, "                return current;\n            default:\n                break;\n        }\n    }\n    return end;\n}\n\n");
+    
+    // keyword lookup
+    fprintf(out, "static inline bool BakedIsBoundary(const char* text, usize available, usize length)\n{\n");
+    fprintf(out, "    if (length >= available) { return true; }\n");
+    fprintf(out, "    u8 next = (u8)(text[length]);\n");
+    fprintf(out, "    return !isalpha(next) && !isdigit(next) && next != '_';\n}\n\n");
+    
+    fprintf(out, "// index of the first keyword in config order that starts at text, -1 when none do\n");
+    fprintf(out, "static inline s32 BakedMatchKeyword(const char* text, usize available)\n{\n");
+    fprintf(out, "    if (available < 2) { return -1; }\n");
+    fprintf(out, "    u32 key = (u32)((u8)(FoldCase(text[0]))) | ((u32)((u8)(FoldCase(text[1]))) << 8);\n");
+    fprintf(out, "    switch ((key * 0x%08Xu) >> %u)\n    {\n", seed, 32 - bits);
+    for (usize p = 0; p < prefix_count; p++)
+    {
+        fprintf(out, "        case %u:\n", Hash(seed, bits, prefixes[p].first, prefixes[p].second));
+        for (usize k = 0; k < keywords->size; k++)
+        {
+            const char* keyword = keywords->data[k];
+            if (FoldByte((u8)(keyword[0])) != prefixes[p].first || FoldByte((u8)(keyword[1])) != prefixes[p].second) { continue; }
+            
+            bool folded = message_table->keyword_case_insensitive && message_table->keyword_case_insensitive[k];
+            usize length = StringLength(keyword);
+            fprintf(out, "            // %s%s\n", keyword, folded ? " (any case)" : "");
+            fprintf(out, "            if (available >= %zu", length);
+            for (usize i = 0; i < length; i++) { WriteByteCompare(out, "text", i, (u8)(keyword[i]), folded); }
+            fprintf(out, " && BakedIsBoundary(text, available, %zu)) { return %zu; }\n", length, k);
+        }
+        fprintf(out, "            return -1;\n");
+    }
+    fprintf(out, "        default:\n            return -1;\n    }\n}\n\n");
+    
+    fprintf(out, "// [symbol][keyword] at text, tried in the same order as the dynamic matcher so the same one wins\n");
+    fprintf(out, "static inline bool BakedMatchAt(const char* text, usize available, s32* symbol, s32* keyword)\n{\n");
+    fprintf(out, "    s32 found = -1;\n");
+    for (usize s = 0; s < symbols->size; s++)
+    {
+        const char* symbol = symbols->data[s];
+        usize length = StringLength(symbol);
+        fprintf(out, "    if (available > %zu", length);
+        for (usize i = 0; i < length; i++) { WriteByteCompare(out, "text", i, (u8)(symbol[i]), false); }
+        fprintf(out, " && (found = BakedMatchKeyword(text + %zu, available - %zu)) >= 0)\n", length, length);
+        fprintf(out, "    {\n        *symbol = %zu;\n        *keyword = found;\n        return true;\n    }\n", s);
+    }
+    fprintf(out, "    return false;\n}\n");
+    
+    bool written = ferror(out) == 0;
+    fclose(out);
+    usize symbol_count = symbols->size;
+    usize keyword_count = keywords->size;
+    free(prefixes);
+    FreeMessageTable(message_table);
+    
+    if (!written)
+    {
+        fprintf(stderr, "generate_matcher, failed writing %s\n", argv[2]);
+        return 1;
+    }
+    printf("generate_matcher, baked %zu symbols and %zu keywords from %s\n", symbol_count, keyword_count, argv[1]);
+    return 0;
+}
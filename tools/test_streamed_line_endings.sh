@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# checks that streamed files (.gz and tar members) find the same matches on the same lines as plain files
+#
+#     tools/test_streamed_line_endings.sh gcc/release/todo_finder
+#
+# cr.txt has only \r line endings and is bigger than one streaming chunk
+# long.txt has a match on line 3 after a line longer than the streaming line limit
+
+if [ -z "$1" ]; then
+    echo "Usage: $0 <todo_finder executable>"
+    exit 1
+fi
+EXE="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+CONFIG="$(cd "$(dirname "$0")/.." && pwd)/coco.todo_config"
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+cd "$WORK_DIR" || exit 1
+cp "$CONFIG" .
+
+for i in $(seq 1 201); do printf '// @todo cr line %d %0200d\r' "$i" 0; done > cr.txt
+for i in $(seq 1 201); do printf '// @todo big line %d %0200d\n' "$i" 0; done > big.txt
+{ printf '%0200000d\n' 0; printf 'b\n'; printf '// @todo after the long line\n'; } > long.txt
+
+mkdir plain
+gzip -c cr.txt > cr.txt.gz
+gzip -c long.txt > long.txt.gz
+tar cf both.tar big.txt cr.txt
+tar czf long.tgz long.txt
+mv cr.txt big.txt long.txt plain/
+
+"$EXE" > output.txt 2>&1
+
+FAILED=0
+expect() {
+    local found
+    found=$(grep -c -- "$2" output.txt)
+    if [ "$found" != "$3" ]; then
+        echo "FAIL $1: expected $3, found $found"
+        FAILED=1
+    fi
+}
+
+expect "cr only plain file"      '\./plain/cr\.txt '        201
+expect "cr only .gz"             '\./cr\.txt\.gz '          201
+expect "cr only tar member"      '\./both\.tar:cr\.txt '    201
+expect "tar member before it"    '\./both\.tar:big\.txt '   201
+expect "plain line after long"   '\./plain/long\.txt  *3: ' 1
+expect ".gz line after long"     '\./long\.txt\.gz  *3: '   1
+expect "tar line after long"     '\./long\.tgz:long\.txt  *3: ' 1
+
+if [ $FAILED -eq 0 ]; then echo "streamed line endings: ok"; fi
+exit $FAILED